@@ -0,0 +1,1216 @@
+#include <dsp/bench/speed_tester.h>
+#include <dsp/filter/fir.h>
+#include <dsp/filter/decimating_fir.h>
+#include <dsp/multirate/power_decimator.h>
+#include <dsp/multirate/half_band_decimator.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <dsp/channel/rx_vfo.h>
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/channel/pfb_channelizer.h>
+#include <dsp/correction/dc_blocker.h>
+#include <dsp/demod/broadcast_fm.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/demod/fm.h>
+#include <dsp/demod/am.h>
+#include <dsp/demod/ssb.h>
+#include <dsp/demod/psk.h>
+#include <dsp/loop/agc.h>
+#include <dsp/loop/fast_agc.h>
+#include <dsp/loop/costas.h>
+#include <dsp/noise_reduction/fm_if.h>
+#include <dsp/noise_reduction/noise_blanker.h>
+#include <dsp/clock_recovery/mm.h>
+#include <dsp/taps/low_pass.h>
+#include <dsp/scheduler.h>
+#include <dsp/kernels/kernels.h>
+#include <dsp/fft/spectrum_pipeline.h>
+#include <dsp/window/nuttall.h>
+#include <command_args.h>
+#include <json.hpp>
+#include <functional>
+#include <climits>
+#include <random>
+#include <thread>
+#include <fstream>
+#include <stdio.h>
+
+using nlohmann::json;
+
+struct BenchCase {
+    std::string block;
+    json params;
+    double samplerate;
+    std::function<double(int durationMs, int bufferSize)> run;
+    std::function<json()> quality = NULL;
+
+    // Correctness check run by --check, returns why the output is wrong or an empty string if it's right
+    std::function<std::string()> check = NULL;
+};
+
+// Buffers hold 5ms of samples like a typical source would send
+int getBufferSize(double samplerate, double interpolation = 1.0) {
+    int size = std::max<int>(samplerate / 200.0, 1024);
+    return std::min<int>(size, (STREAM_BUFFER_SIZE / 2) / std::max<double>(interpolation, 1.0));
+}
+
+template <class I, class O>
+double measure(dsp::stream<I>& in, dsp::Processor<I, O>& blk, int durationMs, int bufferSize) {
+    dsp::bench::SpeedTester<I, O> tester(&in, &blk.out);
+    blk.start();
+    double sps = tester.benchmark(durationMs, bufferSize);
+    blk.stop();
+    return sps;
+}
+
+// SNR of a 1KHz tone sent over wideband FM with noise, demodulated with or without (bins = 0) FMIF noise reduction
+double fmifAudioSNR(int bins, int hop) {
+    const double samplerate = 250e3;
+    const double toneFreq = 1e3;
+    const int count = 250000;
+
+    // Modulate the tone at 50KHz deviation and add noise 10dB below the carrier
+    dsp::complex_t* buf = dsp::buffer::alloc<dsp::complex_t>(count);
+    float* audio = dsp::buffer::alloc<float>(count);
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> noise(0.0f, sqrtf(0.1f / 2.0f));
+    double phase = 0.0;
+    for (int i = 0; i < count; i++) {
+        phase += 2.0 * FL_M_PI * 50e3 * sin(2.0 * FL_M_PI * toneFreq * (double)i / samplerate) / samplerate;
+        buf[i] = { (float)cos(phase) + noise(rng), (float)sin(phase) + noise(rng) };
+    }
+
+    // Remove noise, demodulate and keep only the audio band
+    dsp::noise_reduction::FMIF fmnr;
+    if (bins) {
+        fmnr.init(NULL, bins, hop);
+        fmnr.process(count, buf, buf);
+    }
+    dsp::demod::Quadrature demod(NULL, 50e3, samplerate);
+    demod.process(count, buf, audio);
+    dsp::tap<float> taps = dsp::taps::lowPass(15e3, 4e3, samplerate);
+    dsp::filter::FIR<float, float> lpf(NULL, taps);
+    lpf.process(count, audio, audio);
+
+    // Fit the tone once filters have settled, everything else is noise
+    int start = count / 10;
+    double sinSum = 0.0, cosSum = 0.0, total = 0.0;
+    for (int i = start; i < count; i++) {
+        double rads = 2.0 * FL_M_PI * toneFreq * (double)i / samplerate;
+        sinSum += audio[i] * sin(rads);
+        cosSum += audio[i] * cos(rads);
+        total += audio[i] * audio[i];
+    }
+    int n = count - start;
+    double tone = 2.0 * (sinSum * sinSum + cosSum * cosSum) / (double)n;
+
+    dsp::taps::free(taps);
+    dsp::buffer::free(buf);
+    dsp::buffer::free(audio);
+    return 10.0 * log10(tone / std::max<double>(total - tone, 1e-30));
+}
+
+// Level in dB and share of the output power of a unit tone at toneOffset, coming out of the channelizer stream bound at
+// boundOffset, where it should be at toneOffset - boundOffset
+struct ToneLevel { double levelDb, share; };
+ToneLevel pfbToneLevel(int channels, double samplerate, double boundOffset, double toneOffset) {
+    const int blockSize = 50000;
+    const int blocks = 8;
+    dsp::stream<dsp::complex_t> in;
+    dsp::stream<dsp::complex_t> out;
+    dsp::channel::PFBChannelizer chan(&in, channels, samplerate);
+    chan.bindStream(&out, boundOffset);
+
+    // Everything the input turns into is collected, minus the last output sample which may not come out
+    int frames = (blocks * blockSize) / (channels / 2) - 1;
+    std::vector<dsp::complex_t> res;
+    std::thread reader([&]() {
+        while ((int)res.size() < frames) {
+            int count = out.read();
+            if (count < 0) { break; }
+            res.insert(res.end(), out.readBuf, out.readBuf + count);
+            out.flush();
+        }
+    });
+
+    chan.start();
+    double phase = 0.0;
+    double delta = 2.0 * DB_M_PI * toneOffset / samplerate;
+    for (int b = 0; b < blocks; b++) {
+        for (int i = 0; i < blockSize; i++) {
+            in.writeBuf[i] = { (float)cos(phase), (float)sin(phase) };
+            phase = fmod(phase + delta, 2.0 * DB_M_PI);
+        }
+        in.swap(blockSize);
+    }
+    reader.join();
+    chan.stop();
+
+    // Fit the tone once the filter bank is full
+    double rads = 2.0 * DB_M_PI * (toneOffset - boundOffset) / chan.getChannelRate();
+    int start = 4 * PFB_CHANNELIZER_TAPS_PER_CHANNEL;
+    double re = 0.0, im = 0.0, total = 0.0;
+    for (int i = start; i < frames; i++) {
+        double c = cos(rads * (double)i), s = -sin(rads * (double)i);
+        re += res[i].re * c - res[i].im * s;
+        im += res[i].re * s + res[i].im * c;
+        total += res[i].re * res[i].re + res[i].im * res[i].im;
+    }
+    int n = frames - start;
+    double tone = (re * re + im * im) / ((double)n * (double)n);
+    return { 10.0 * log10(tone), tone * (double)n / total };
+}
+
+// Tones must come out of the channels at the expected frequency and level, wherever they land between channel centers.
+// The level is in dB, the passband droops by about 0.3dB at the edge of the widest signal a channel takes.
+#define PFB_CHECK_CENTER_TOLERANCE  0.01
+#define PFB_CHECK_EDGE_TOLERANCE    0.5
+#define PFB_CHECK_MIN_SHARE         0.9999
+
+// Tones further than 1.75 channel spacings from a stream alias into the band of the widest signal it takes, where they
+// must be at least this many dB under their level. The filter bank gets about 85dB.
+#define PFB_CHECK_MIN_REJECTION     80.0
+
+std::string checkPFBChannelizer(int channels, double samplerate) {
+    // Channel centers, halfway between channels, the edges of the last channels and negative frequencies. The tones
+    // at the offset come out at 0 Hz, the others at the edge of the widest signal a channel takes.
+    double spacing = samplerate / (double)channels;
+    double maxBw = samplerate / (2.0 * (double)channels);
+    double offsets[] = { 0.0, spacing, -spacing, 0.3 * spacing, -2.7 * spacing, 0.5 * spacing, -0.5 * spacing,
+                         3.5 * spacing, (channels / 2 - 0.5) * spacing, -(channels / 2 - 0.5) * spacing };
+    for (double offset : offsets) {
+        for (double shift : { 0.0, maxBw / 2.0, -maxBw / 2.0 }) {
+            ToneLevel lvl = pfbToneLevel(channels, samplerate, offset, offset + shift);
+            double tolerance = (shift == 0.0) ? PFB_CHECK_CENTER_TOLERANCE : PFB_CHECK_EDGE_TOLERANCE;
+            if (!(fabs(lvl.levelDb) <= tolerance) || !(lvl.share >= PFB_CHECK_MIN_SHARE)) {
+                char buf[256];
+                snprintf(buf, sizeof(buf), "tone at %+.0f Hz from a stream bound at %+.0f Hz came out at %.3f dB with %.4f of the power",
+                         offset + shift, offset, lvl.levelDb, lvl.share);
+                return buf;
+            }
+        }
+    }
+
+    // Tones in the channels two spacings away and around them, which come out at the output rate, twice the spacing,
+    // within the band of the widest signal a channel takes. Streams are bound on and off channel centers.
+    for (double offset : { 0.0, 0.3 * spacing, -2.7 * spacing }) {
+        for (double distance : { 1.75, 2.0, 2.25, -1.75, -2.0, -2.25 }) {
+            ToneLevel lvl = pfbToneLevel(channels, samplerate, offset, offset + distance * spacing);
+            if (!(lvl.levelDb <= -PFB_CHECK_MIN_REJECTION)) {
+                char buf[256];
+                snprintf(buf, sizeof(buf), "tone at %+.0f Hz aliased into a stream bound at %+.0f Hz at %.1f dB",
+                         offset + distance * spacing, offset, lvl.levelDb);
+                return buf;
+            }
+        }
+    }
+    return "";
+}
+
+// Samples per second going through a kernel called on buffers of the given size
+double measureKernel(int durationMs, int bufferSize, std::function<void()> call) {
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::milliseconds(durationMs);
+    int64_t samples = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        call();
+        samples += bufferSize;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)samples / elapsed;
+}
+
+// Inputs of the kernel throughput cases
+struct KernelData {
+    std::vector<dsp::complex_t> iq;
+    std::vector<float> levels;
+    std::vector<uint32_t> palette;
+
+    KernelData(int size) : iq(size), levels(size), palette(256) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> amp(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> db(-160.0f, 20.0f);
+        for (auto& s : iq) { s = { amp(rng), amp(rng) }; }
+        for (auto& l : levels) { l = db(rng); }
+        for (int i = 0; i < (int)palette.size(); i++) { palette[i] = i * 0x010101; }
+    }
+};
+
+// Largest errors the kernel checks accept: the phase in radians against atan2f, the amplitude sum relative to the sum
+// in order and the palette index against the old waterfall loop
+#define KERNEL_PHASE5_TOLERANCE     2e-5f
+#define KERNEL_PHASE9_TOLERANCE     5e-7f
+#define KERNEL_SUM_TOLERANCE        1e-4f
+#define KERNEL_PALETTE_TOLERANCE    0
+
+// Inputs for the kernel checks, random values over a wide range of magnitudes and the edge cases of each kernel
+std::vector<dsp::complex_t> kernelCheckIQ() {
+    std::vector<dsp::complex_t> iq = {
+        { 0.0f, 0.0f }, { -0.0f, 0.0f }, { 0.0f, -0.0f }, { -0.0f, -0.0f },
+        { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f }, { -1.0f, -0.0f },
+        { 1.0f, 1.0f }, { -1.0f, 1.0f }, { 1.0f, -1.0f }, { -1.0f, -1.0f },
+        { 1e-15f, 1e15f }, { -1e15f, 1e-15f }, { 1e-15f, 0.0f }
+    };
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> amp(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> decade(-15.0f, 15.0f);
+    for (int i = 0; i < 65536; i++) {
+        float scale = (i % 2) ? powf(10.0f, decade(rng)) : 1.0f;
+        iq.push_back({ amp(rng) * scale, amp(rng) * scale });
+    }
+    return iq;
+}
+
+// Lengths the kernels are called with, so that every remainder of their vector loops is covered
+const int KERNEL_CHECK_COUNTS[] = { 0, 1, 7, 15, 16, 17, 255, 257, 4099 };
+
+std::string checkPhase(decltype(dsp::kernels::Table::phase) phase, float tolerance) {
+    std::vector<dsp::complex_t> iq = kernelCheckIQ();
+    const float scale = 0.5f;
+    for (int count : KERNEL_CHECK_COUNTS) {
+        // The whole input is used once, then the shorter calls check the loop tails and that nothing is written past them
+        for (int n : { count, (int)iq.size() }) {
+            std::vector<float> out(n + 1, 1234.0f);
+            phase(out.data(), iq.data(), scale, n);
+            if (out[n] != 1234.0f) { return "wrote past " + std::to_string(n) + " samples"; }
+            for (int i = 0; i < n; i++) {
+                // The phase of zero isn't defined, atan2f's depends on the signs of the zeros but any angle will do
+                float ref = atan2f(iq[i].im, iq[i].re) * scale;
+                if (iq[i].re == 0.0f && iq[i].im == 0.0f) { ref = out[i]; }
+
+                // Both ends of the range are the same angle
+                float err = fabsf(out[i] - ref);
+                err = std::min<float>(err, fabsf(err - 2.0f * FL_M_PI * scale));
+                if (!(err <= tolerance * scale)) {
+                    char buf[256];
+                    snprintf(buf, sizeof(buf), "phase of (%g, %g) is %g instead of %g", iq[i].re, iq[i].im, out[i], ref);
+                    return buf;
+                }
+            }
+        }
+    }
+    return "";
+}
+
+// The squelch used to take the magnitudes with VOLK and add them up in order
+float squelchAmplitudeSum(const dsp::complex_t* in, int count) {
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) { sum += sqrtf(in[i].re * in[i].re + in[i].im * in[i].im); }
+    return sum;
+}
+
+std::string checkAmplitudeSum(const dsp::kernels::Table* kern, float tolerance) {
+    // Squelch inputs are in range, the values too large to be squared are left out
+    std::vector<dsp::complex_t> iq = kernelCheckIQ();
+    iq.erase(std::remove_if(iq.begin(), iq.end(), [](dsp::complex_t s) { return fabsf(s.re) > 1e15f || fabsf(s.im) > 1e15f; }), iq.end());
+    for (int n : KERNEL_CHECK_COUNTS) {
+        for (int start : { 0, 3 }) {
+            float res = kern->amplitudeSum(&iq[start], n);
+            float ref = squelchAmplitudeSum(&iq[start], n);
+            if (!(fabsf(res - ref) <= tolerance * ref)) {
+                char buf[256];
+                snprintf(buf, sizeof(buf), "sum of %d amplitudes is %g instead of %g", n, res, ref);
+                return buf;
+            }
+        }
+    }
+    return "";
+}
+
+// The waterfall used to scale the value to 0..1 then to the palette size
+uint32_t waterfallPaletteEntry(float val, float min, float max, const uint32_t* palette, int paletteSize) {
+    float pixel = (std::clamp<float>(val, min, max) - min) / (max - min);
+    return palette[(int)(pixel * (paletteSize - 1))];
+}
+
+std::string checkPaletteMap(const dsp::kernels::Table* kern, int maxIndexError) {
+    // Levels across the range with the bounds themselves and values just inside and outside of them
+    const float min = -150.0f;
+    const float max = 0.0f;
+    std::vector<float> levels = { min, max, nextafterf(min, -INFINITY), nextafterf(min, INFINITY), nextafterf(max, -INFINITY),
+                                  nextafterf(max, INFINITY), -INFINITY, INFINITY, -1e30f, 1e30f };
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> db(-200.0f, 50.0f);
+    for (int i = 0; i < 65536; i++) { levels.push_back(db(rng)); }
+
+    // The entries are their own index so that the index error can be measured
+    std::vector<uint32_t> palette(256);
+    for (int i = 0; i < (int)palette.size(); i++) { palette[i] = i; }
+
+    for (int count : KERNEL_CHECK_COUNTS) {
+        for (int n : { count, (int)levels.size() }) {
+            std::vector<uint32_t> out(n + 1, 0xDEADBEEF);
+            kern->paletteMap(out.data(), levels.data(), n, min, max, palette.data(), palette.size());
+            if (out[n] != 0xDEADBEEF) { return "wrote past " + std::to_string(n) + " values"; }
+            for (int i = 0; i < n; i++) {
+                int ref = waterfallPaletteEntry(levels[i], min, max, palette.data(), palette.size());
+                if (abs((int)out[i] - ref) > maxIndexError) {
+                    char buf[256];
+                    snprintf(buf, sizeof(buf), "%g maps to entry %u instead of %d", levels[i], out[i], ref);
+                    return buf;
+                }
+            }
+        }
+    }
+
+    // The old loop didn't handle NaNs, they must not read outside of the palette
+    float nan = NAN;
+    uint32_t out;
+    kern->paletteMap(&out, &nan, 1, min, max, palette.data(), palette.size());
+    if (out != 0) { return "NaN maps to entry " + std::to_string(out) + " instead of 0"; }
+    return "";
+}
+
+void addKernelCases(std::vector<BenchCase>& cases) {
+    for (int l = dsp::kernels::LEVEL_GENERIC; l < dsp::kernels::_LEVEL_COUNT; l++) {
+        dsp::kernels::Level level = (dsp::kernels::Level)l;
+        const dsp::kernels::Table* kern = dsp::kernels::getLevel(level);
+        if (!kern) { continue; }
+        std::string name = dsp::kernels::getLevelName(level);
+
+        for (int terms : { 5, 9 }) {
+            auto phase = (terms == 5) ? kern->fastPhase : kern->phase;
+            BenchCase bc = { "Kernel", { { "kernel", "phase" }, { "terms", terms }, { "level", name } }, 10e6, [=](int durationMs, int bufferSize) {
+                KernelData data(bufferSize);
+                std::vector<float> out(bufferSize);
+                return measureKernel(durationMs, bufferSize, [&]() { phase(out.data(), data.iq.data(), 1.0f, bufferSize); });
+            } };
+            bc.check = [=]() { return checkPhase(phase, (terms == 5) ? KERNEL_PHASE5_TOLERANCE : KERNEL_PHASE9_TOLERANCE); };
+            cases.push_back(bc);
+        }
+
+        BenchCase sum = { "Kernel", { { "kernel", "amplitudeSum" }, { "level", name } }, 10e6, [=](int durationMs, int bufferSize) {
+            KernelData data(bufferSize);
+            volatile float res;
+            return measureKernel(durationMs, bufferSize, [&]() { res = kern->amplitudeSum(data.iq.data(), bufferSize); });
+        } };
+        sum.check = [=]() { return checkAmplitudeSum(kern, KERNEL_SUM_TOLERANCE); };
+        cases.push_back(sum);
+
+        BenchCase pal = { "Kernel", { { "kernel", "paletteMap" }, { "level", name } }, 10e6, [=](int durationMs, int bufferSize) {
+            KernelData data(bufferSize);
+            std::vector<uint32_t> out(bufferSize);
+            return measureKernel(durationMs, bufferSize, [&]() {
+                kern->paletteMap(out.data(), data.levels.data(), bufferSize, -150.0f, 0.0f, data.palette.data(), data.palette.size());
+            });
+        } };
+        pal.check = [=]() { return checkPaletteMap(kern, KERNEL_PALETTE_TOLERANCE); };
+        cases.push_back(pal);
+    }
+}
+
+// Taps generated per second, bufferSize being the filter length
+void addTapCases(std::vector<BenchCase>& cases) {
+    cases.push_back({ "Taps", { { "generator", "windowedSinc" } }, 10e6, [=](int durationMs, int bufferSize) {
+        return measureKernel(durationMs, bufferSize, [&]() {
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(bufferSize, 0.01, dsp::window::nuttall);
+            dsp::taps::free(taps);
+        });
+    } });
+    cases.push_back({ "Taps", { { "generator", "cosineWindowedSinc" } }, 10e6, [=](int durationMs, int bufferSize) {
+        return measureKernel(durationMs, bufferSize, [&]() {
+            dsp::tap<float> taps = dsp::taps::cosineWindowedSinc(bufferSize, 0.01, dsp::window::NUTTALL_COEFS, dsp::window::NUTTALL_COEF_COUNT);
+            dsp::taps::free(taps);
+        });
+    } });
+
+    // Same settings every time, like a VFO going back to a previous bandwidth
+    cases.push_back({ "Taps", { { "generator", "lowPass" }, { "cached", true } }, 10e6, [=](int durationMs, int bufferSize) {
+        double transWidth = 3.8 * 10e6 / (double)bufferSize;
+        return measureKernel(durationMs, bufferSize, [&]() {
+            dsp::tap<float> taps = dsp::taps::lowPass(100e3, transWidth, 10e6);
+            dsp::taps::free(taps);
+        });
+    } });
+}
+
+// Largest difference in dB between the averaged spectrum and the mean power of its frames
+#define SPECTRUM_CHECK_TOLERANCE    0.01
+
+// Keeps every spectrum handed over, cut to the pixels of its view
+struct SpectrumCapture {
+    dsp::fft::SpectrumPipeline* pipeline = NULL;
+    std::vector<float> spectrum;
+    std::vector<std::vector<float>> delivered;
+    int count = 0;
+
+    static float* acquire(void* ctx) {
+        return ((SpectrumCapture*)ctx)->spectrum.data();
+    }
+
+    static void release(void* ctx) {
+        SpectrumCapture* _this = (SpectrumCapture*)ctx;
+        int pixels = _this->pipeline->getDeliveredView().pixels;
+        int size = pixels ? pixels : _this->spectrum.size();
+        _this->delivered.push_back(std::vector<float>(_this->spectrum.begin(), _this->spectrum.begin() + size));
+        _this->count++;
+    }
+};
+
+// A tone at the given bin over noise, different in every frame
+std::vector<dsp::complex_t> spectrumCheckFrame(std::mt19937& rng, int fftSize, double bin) {
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<dsp::complex_t> frame(fftSize);
+    for (int i = 0; i < fftSize; i++) {
+        double rads = 2.0 * DB_M_PI * bin * (double)i / (double)fftSize;
+        frame[i] = { (float)(100.0 * cos(rads)) + noise(rng), (float)(100.0 * sin(rads)) + noise(rng) };
+    }
+    return frame;
+}
+
+// An averaged spectrum must be the mean power of its frames on the same scale as a single frame's spectrum, each
+// frame's being the windowed FFT through volk_32fc_s32f_power_spectrum_32f like the pipeline does without averaging
+std::string checkSpectrumAverages(int fftSize, int averages) {
+    std::mt19937 rng(1);
+    std::vector<dsp::complex_t> frames;
+    for (int f = 0; f < averages; f++) {
+        std::vector<dsp::complex_t> frame = spectrumCheckFrame(rng, fftSize, 0.1234 * fftSize);
+        frames.insert(frames.end(), frame.begin(), frame.end());
+    }
+    std::vector<float> window(fftSize);
+    for (int i = 0; i < fftSize; i++) { window[i] = dsp::window::nuttall(i, fftSize); }
+
+    // Mean power of the frames, each one converted back from dB
+    dsp::fft::Plan plan(fftSize, FFTW_FORWARD);
+    dsp::complex_t* fftIn = (dsp::complex_t*)fftwf_malloc(fftSize * sizeof(dsp::complex_t));
+    dsp::complex_t* fftOut = (dsp::complex_t*)fftwf_malloc(fftSize * sizeof(dsp::complex_t));
+    std::vector<float> frameDb(fftSize);
+    std::vector<double> meanPower(fftSize, 0.0);
+    for (int f = 0; f < averages; f++) {
+        volk_32fc_32f_multiply_32fc((lv_32fc_t*)fftIn, (lv_32fc_t*)&frames[f * fftSize], window.data(), fftSize);
+        plan.execute(fftIn, fftOut);
+        volk_32fc_s32f_power_spectrum_32f(frameDb.data(), (lv_32fc_t*)fftOut, fftSize, fftSize);
+        for (int i = 0; i < fftSize; i++) { meanPower[i] += pow(10.0, frameDb[i] / 10.0) / (double)averages; }
+    }
+    fftwf_free(fftIn);
+    fftwf_free(fftOut);
+
+    SpectrumCapture cap;
+    cap.spectrum.resize(fftSize);
+    {
+        dsp::fft::SpectrumPipeline pipeline;
+        cap.pipeline = &pipeline;
+        pipeline.init(2, SpectrumCapture::acquire, SpectrumCapture::release, &cap);
+        pipeline.setParams(fftSize, window.data(), fftSize, averages);
+        for (int f = 0; f < averages; f++) { pipeline.push(&frames[f * fftSize], fftSize); }
+        pipeline.flush();
+    }
+
+    if (cap.count != 1) { return "handed over " + std::to_string(cap.count) + " spectra for one group of frames"; }
+    for (int i = 0; i < fftSize; i++) {
+        double expected = 10.0 * log10(meanPower[i]);
+        if (!(fabs(cap.spectrum[i] - expected) <= SPECTRUM_CHECK_TOLERANCE)) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "bin %d is %.3f dB, the mean power of the frames is %.3f dB", i, cap.spectrum[i], expected);
+            return buf;
+        }
+    }
+    return "";
+}
+
+// Every spectrum handed over by several workers must be the one a single thread computes for the frame at that position
+std::string checkSpectrumThreads(int threads, int fftSize) {
+    // Every worker gets a few frames
+    const int frameCount = 3 * threads + 1;
+    std::mt19937 rng(1);
+    std::vector<float> window(fftSize);
+    for (int i = 0; i < fftSize; i++) { window[i] = dsp::window::nuttall(i, fftSize); }
+    std::vector<std::vector<dsp::complex_t>> frames;
+    for (int f = 0; f < frameCount; f++) { frames.push_back(spectrumCheckFrame(rng, fftSize, 0.37 * (double)fftSize * f / frameCount)); }
+
+    SpectrumCapture cap;
+    cap.spectrum.resize(fftSize);
+    {
+        dsp::fft::SpectrumPipeline pipeline;
+        cap.pipeline = &pipeline;
+        pipeline.init(threads, SpectrumCapture::acquire, SpectrumCapture::release, &cap);
+        pipeline.setParams(fftSize, window.data(), fftSize);
+        for (auto& frame : frames) { pipeline.push(frame.data(), fftSize); }
+        pipeline.flush();
+    }
+    if (cap.count != frameCount) { return "handed over " + std::to_string(cap.count) + " spectra for " + std::to_string(frameCount) + " frames"; }
+
+    dsp::fft::Plan plan(fftSize, FFTW_FORWARD);
+    dsp::complex_t* fftIn = (dsp::complex_t*)fftwf_malloc(fftSize * sizeof(dsp::complex_t));
+    dsp::complex_t* fftOut = (dsp::complex_t*)fftwf_malloc(fftSize * sizeof(dsp::complex_t));
+    std::vector<float> ref(fftSize);
+    std::string err;
+    for (int f = 0; f < frameCount && err.empty(); f++) {
+        volk_32fc_32f_multiply_32fc((lv_32fc_t*)fftIn, (lv_32fc_t*)frames[f].data(), window.data(), fftSize);
+        plan.execute(fftIn, fftOut);
+        volk_32fc_s32f_power_spectrum_32f(ref.data(), (lv_32fc_t*)fftOut, fftSize, fftSize);
+        for (int i = 0; i < fftSize; i++) {
+            if (!(fabs(cap.delivered[f][i] - ref[i]) <= SPECTRUM_CHECK_TOLERANCE)) {
+                char buf[128];
+                snprintf(buf, sizeof(buf), "spectrum %d has %.3f dB in bin %d instead of %.3f dB", f, cap.delivered[f][i], i, ref[i]);
+                err = buf;
+                break;
+            }
+        }
+    }
+    fftwf_free(fftIn);
+    fftwf_free(fftOut);
+    return err;
+}
+
+// Each pixel of a reduced spectrum must be the strongest bin or the mean power of the bins from its left edge up to
+// the next one's, at least one bin, computed here from the whole spectrum of the same frame
+std::string checkSpectrumReduce(dsp::fft::ReduceMode mode, int pixels, double start, double width) {
+    const int fftSize = 4096;
+    std::mt19937 rng(1);
+    std::vector<dsp::complex_t> frame = spectrumCheckFrame(rng, fftSize, 1234.5);
+    std::vector<float> window(fftSize);
+    for (int i = 0; i < fftSize; i++) { window[i] = dsp::window::nuttall(i, fftSize); }
+
+    SpectrumCapture cap;
+    cap.spectrum.resize(fftSize);
+    {
+        dsp::fft::SpectrumPipeline pipeline;
+        cap.pipeline = &pipeline;
+        pipeline.init(2, SpectrumCapture::acquire, SpectrumCapture::release, &cap);
+        pipeline.setParams(fftSize, window.data(), fftSize);
+        pipeline.push(frame.data(), fftSize);
+        dsp::fft::SpectrumView view;
+        view.pixels = pixels;
+        view.start = start;
+        view.width = width;
+        view.mode = mode;
+        pipeline.setView(view);
+        pipeline.push(frame.data(), fftSize);
+        pipeline.flush();
+    }
+    if (cap.delivered.size() != 2 || (int)cap.delivered[1].size() != pixels) { return "the reduced spectrum wasn't handed over"; }
+
+    const std::vector<float>& full = cap.delivered[0];
+    const std::vector<float>& reduced = cap.delivered[1];
+    double binsPerPixel = width * (double)fftSize / (double)pixels;
+    for (int i = 0; i < pixels; i++) {
+        int lo = floor(start * (double)fftSize + (double)i * binsPerPixel);
+        int hi = std::max<int>(lo + 1, floor(start * (double)fftSize + (double)(i + 1) * binsPerPixel));
+        double expected = -INFINITY;
+        if (lo < fftSize && hi > 0) {
+            lo = std::max<int>(lo, 0);
+            hi = std::min<int>(hi, fftSize);
+            double power = 0.0;
+            for (int j = lo; j < hi; j++) {
+                if (mode == dsp::fft::REDUCE_MEAN) { power += pow(10.0, full[j] / 10.0) / (double)(hi - lo); }
+                else { expected = std::max<double>(expected, full[j]); }
+            }
+            if (mode == dsp::fft::REDUCE_MEAN) { expected = 10.0 * log10(power); }
+        }
+        bool ok = std::isinf(expected) ? (reduced[i] == expected) : (fabs(reduced[i] - expected) <= SPECTRUM_CHECK_TOLERANCE);
+        if (!ok) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "pixel %d is %.3f dB instead of %.3f dB", i, reduced[i], expected);
+            return buf;
+        }
+    }
+    return "";
+}
+
+// With several workers the spectra must still come out in the order the frames went in, each frame having its tone
+// in a different bin
+std::string checkSpectrumOrder(int threads) {
+    const int fftSize = 1024;
+    const int frameCount = 64;
+    std::mt19937 rng(1);
+    std::vector<float> window(fftSize, 1.0f);
+
+    SpectrumCapture cap;
+    cap.spectrum.resize(fftSize);
+    {
+        dsp::fft::SpectrumPipeline pipeline;
+        cap.pipeline = &pipeline;
+        pipeline.init(threads, SpectrumCapture::acquire, SpectrumCapture::release, &cap);
+        pipeline.setParams(fftSize, window.data(), fftSize);
+        if (pipeline.getThreads() != threads) { return "started " + std::to_string(pipeline.getThreads()) + " workers"; }
+        for (int f = 0; f < frameCount; f++) {
+            std::vector<dsp::complex_t> frame = spectrumCheckFrame(rng, fftSize, (f * 37) % fftSize);
+            pipeline.push(frame.data(), fftSize);
+        }
+        pipeline.flush();
+    }
+    if (cap.count != frameCount) { return "handed over " + std::to_string(cap.count) + " spectra for " + std::to_string(frameCount) + " frames"; }
+    for (int f = 0; f < frameCount; f++) {
+        int peak = std::max_element(cap.delivered[f].begin(), cap.delivered[f].end()) - cap.delivered[f].begin();
+        if (peak != (f * 37) % fftSize) {
+            return "spectrum " + std::to_string(f) + " has its tone in bin " + std::to_string(peak) + " instead of " + std::to_string((f * 37) % fftSize);
+        }
+    }
+    return "";
+}
+
+// Spectra of a full size frame, with the FFT size given in samples per second since it doesn't depend on the buffer size
+void addSpectrumCases(std::vector<BenchCase>& cases) {
+    for (int fftSize : { 65536, 1048576 }) {
+        for (int threads : { 1, 2, 4 }) {
+            cases.push_back({ "SpectrumPipeline", { { "fftSize", fftSize }, { "threads", threads } }, 10e6, [=](int durationMs, int bufferSize) {
+                std::vector<float> spectrum(fftSize);
+                dsp::fft::SpectrumPipeline pipeline;
+                pipeline.init(threads, [](void* ctx) { return (float*)ctx; }, [](void* ctx) {}, spectrum.data());
+                std::vector<float> window(fftSize, 1.0f);
+                pipeline.setParams(fftSize, window.data(), fftSize);
+                std::vector<dsp::complex_t> frame(fftSize);
+                for (int i = 0; i < fftSize; i++) { frame[i] = { (float)(i % 7), (float)(i % 5) }; }
+                double sps = measureKernel(durationMs, fftSize, [&]() { pipeline.push(frame.data(), fftSize); });
+                pipeline.flush();
+                return sps;
+            }, NULL, [=]() { return checkSpectrumThreads(threads, fftSize); } });
+        }
+    }
+
+    // Only checked, averaging costs the same as handing over every frame
+    for (int averages : { 1, 4 }) {
+        BenchCase bc = { "SpectrumPipeline", { { "fftSize", 4096 }, { "averages", averages } }, 10e6, NULL };
+        bc.check = [=]() { return checkSpectrumAverages(4096, averages); };
+        cases.push_back(bc);
+    }
+
+    for (auto mode : { dsp::fft::REDUCE_MAX, dsp::fft::REDUCE_MEAN }) {
+        // Several bins per pixel, zoomed past the resolution of the FFT, and partly off the spectrum
+        for (auto [pixels, start, width] : std::vector<std::tuple<int, double, double>>{ { 1000, 0.0, 1.0 }, { 300, 0.25, 0.01 }, { 500, -0.1, 0.5 } }) {
+            BenchCase bc = { "SpectrumPipeline", { { "reduce", (mode == dsp::fft::REDUCE_MEAN) ? "mean" : "max" }, { "pixels", pixels }, { "start", start }, { "width", width } }, 10e6, NULL };
+            bc.check = [=]() { return checkSpectrumReduce(mode, pixels, start, width); };
+            cases.push_back(bc);
+        }
+    }
+
+    for (int threads : { 2, 4 }) {
+        BenchCase bc = { "SpectrumPipeline", { { "order", true }, { "threads", threads } }, 10e6, NULL };
+        bc.check = [=]() { return checkSpectrumOrder(threads); };
+        cases.push_back(bc);
+    }
+}
+
+// Largest difference between the outputs of FFT and direct form convolution, relative to the largest output
+#define FIR_CHECK_TOLERANCE     1e-5
+
+// Odd block sizes and sizes that make the FFT grow and shrink
+const int firCheckBlockSizes[] = { 1, 7, 4096, 333, 12000, 64, 1023, 5000, 2, 777 };
+
+double sampleMagnitude(float s) { return fabs(s); }
+double sampleMagnitude(dsp::complex_t s) { return s.amplitude(); }
+
+// Run both blocks on the same noise cut in odd blocks, the tested one in place, which is the hardest case for
+// decimators. The largest difference is relative to the largest output.
+template <class D, class Ref, class Test>
+std::string checkSameOutput(Ref& ref, Test& test, double tolerance, const char* name) {
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    double maxErr = 0.0, maxOut = 0.0;
+    for (int count : firCheckBlockSizes) {
+        std::vector<D> in(count), refOut(ref.getOutputSize(count)), out(count);
+        for (auto& s : in) {
+            if constexpr (std::is_same_v<D, float>) { s = noise(rng); }
+            else { s = { noise(rng), noise(rng) }; }
+        }
+        out = in;
+        int refCount = ref.process(count, in.data(), refOut.data());
+        int outCount = test.process(count, out.data(), out.data());
+        if (refCount != outCount) { return "a block of " + std::to_string(count) + " gave a different number of outputs"; }
+        for (int i = 0; i < outCount; i++) {
+            maxErr = std::max<double>(maxErr, sampleMagnitude(out[i] - refOut[i]));
+            maxOut = std::max<double>(maxOut, sampleMagnitude(refOut[i]));
+        }
+    }
+    if (!(maxErr <= tolerance * maxOut)) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s output is off by up to %g for outputs up to %g", name, maxErr, maxOut);
+        return buf;
+    }
+    return "";
+}
+
+template <class D, class Filter>
+std::string checkFIRMethods(Filter& direct, Filter& fft) {
+    direct.setFFTThreshold(INT_MAX);
+    fft.setFFTThreshold(0);
+    if (direct.isUsingFFT() || !fft.isUsingFFT()) { return "the methods weren't forced"; }
+    return checkSameOutput<D>(direct, fft, FIR_CHECK_TOLERANCE, "FFT");
+}
+
+template <class D>
+std::string checkFIRMethods(int tapCount, double cutoff, double samplerate) {
+    dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, cutoff, samplerate, dsp::window::nuttall);
+    dsp::filter::FIR<D, float> direct(NULL, taps), fft(NULL, taps);
+    dsp::taps::free(taps);
+    return checkFIRMethods<D>(direct, fft);
+}
+
+std::string checkDecimatingFIRMethods(int tapCount, int decim) {
+    dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 1.2e6 / decim, 2.4e6, dsp::window::nuttall);
+    dsp::filter::DecimatingFIR<dsp::complex_t, float> direct(NULL, taps, decim), fft(NULL, taps, decim);
+    dsp::taps::free(taps);
+    return checkFIRMethods<dsp::complex_t>(direct, fft);
+}
+
+void addFilterCases(std::vector<BenchCase>& cases) {
+    for (int tapCount : { 31, 127, 511 }) {
+        cases.push_back({ "FIR", { { "type", "complex" }, { "taps", tapCount } }, 2.4e6, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 100e3, 2.4e6, dsp::window::nuttall);
+            dsp::filter::FIR<dsp::complex_t, float> fir(&in, taps);
+            double sps = measure(in, fir, durationMs, bufferSize);
+            dsp::taps::free(taps);
+            return sps;
+        } });
+        cases.push_back({ "FIR", { { "type", "float" }, { "taps", tapCount } }, 48e3, [=](int durationMs, int bufferSize) {
+            dsp::stream<float> in;
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 5e3, 48e3, dsp::window::nuttall);
+            dsp::filter::FIR<float, float> fir(&in, taps);
+            double sps = measure(in, fir, durationMs, bufferSize);
+            dsp::taps::free(taps);
+            return sps;
+        } });
+    }
+
+    // Both convolution methods over a range of tap counts, used to find the crossover set by FIR_FFT_THRESHOLD
+    for (int tapCount : { 3, 5, 7, 9, 11, 15, 23, 31, 47, 63, 127, 255, 511, 1023, 2047 }) {
+        for (bool fft : { false, true }) {
+            cases.push_back({ "FIR", { { "type", "complex" }, { "taps", tapCount }, { "method", fft ? "fft" : "direct" } }, 2.4e6, [=](int durationMs, int bufferSize) {
+                dsp::stream<dsp::complex_t> in;
+                dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 100e3, 2.4e6, dsp::window::nuttall);
+                dsp::filter::FIR<dsp::complex_t, float> fir(&in, taps);
+                fir.setFFTThreshold(fft ? 0 : INT_MAX);
+                double sps = measure(in, fir, durationMs, bufferSize);
+                dsp::taps::free(taps);
+                return sps;
+            }, NULL, fft ? std::function<std::string()>([=]() { return checkFIRMethods<dsp::complex_t>(tapCount, 100e3, 2.4e6); }) : NULL });
+            cases.push_back({ "FIR", { { "type", "float" }, { "taps", tapCount }, { "method", fft ? "fft" : "direct" } }, 48e3, [=](int durationMs, int bufferSize) {
+                dsp::stream<float> in;
+                dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 5e3, 48e3, dsp::window::nuttall);
+                dsp::filter::FIR<float, float> fir(&in, taps);
+                fir.setFFTThreshold(fft ? 0 : INT_MAX);
+                double sps = measure(in, fir, durationMs, bufferSize);
+                dsp::taps::free(taps);
+                return sps;
+            }, NULL, fft ? std::function<std::string()>([=]() { return checkFIRMethods<float>(tapCount, 5e3, 48e3); }) : NULL });
+        }
+    }
+
+    for (int decim : { 2, 4, 8 }) {
+        int tapCount = 32 * decim - 1;
+        cases.push_back({ "DecimatingFIR", { { "decimation", decim }, { "taps", tapCount } }, 2.4e6, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 1.2e6 / decim, 2.4e6, dsp::window::nuttall);
+            dsp::filter::DecimatingFIR<dsp::complex_t, float> fir(&in, taps, decim);
+            double sps = measure(in, fir, durationMs, bufferSize);
+            dsp::taps::free(taps);
+            return sps;
+        } });
+    }
+
+    // The threshold compares the tap count over the decimation, so the crossover is also measured for decimating filters
+    for (int decim : { 2, 4, 8, 16 }) {
+        for (int tapCount : { 4 * decim - 1, 8 * decim - 1, 16 * decim - 1, 32 * decim - 1 }) {
+            for (bool fft : { false, true }) {
+                cases.push_back({ "DecimatingFIR", { { "decimation", decim }, { "taps", tapCount }, { "method", fft ? "fft" : "direct" } }, 2.4e6, [=](int durationMs, int bufferSize) {
+                    dsp::stream<dsp::complex_t> in;
+                    dsp::tap<float> taps = dsp::taps::windowedSinc<float>(tapCount, 1.2e6 / decim, 2.4e6, dsp::window::nuttall);
+                    dsp::filter::DecimatingFIR<dsp::complex_t, float> fir(&in, taps, decim);
+                    fir.setFFTThreshold(fft ? 0 : INT_MAX);
+                    double sps = measure(in, fir, durationMs, bufferSize);
+                    dsp::taps::free(taps);
+                    return sps;
+                }, NULL, fft ? std::function<std::string()>([=]() { return checkDecimatingFIRMethods(tapCount, decim); }) : NULL });
+            }
+        }
+    }
+}
+
+// Largest difference between HalfBandDecimator and DecimatingFIR, relative to the largest output. Adding the symmetric
+// pairs first rounds differently from the dot product, by 2e-7 to 6e-6 of the plan stages depending on the VOLK kernel.
+#define HALF_BAND_CHECK_TOLERANCE   2e-5
+
+std::string checkHalfBandDecimator(int len, const float* planTaps) {
+    dsp::tap<float> taps = dsp::taps::fromArray<float>(len, planTaps);
+    dsp::filter::DecimatingFIR<dsp::complex_t, float> ref(NULL, taps, 2);
+    dsp::multirate::HalfBandDecimator<dsp::complex_t> decim(NULL, taps);
+    ref.setFFTThreshold(INT_MAX);
+    std::string err = checkSameOutput<dsp::complex_t>(ref, decim, HALF_BAND_CHECK_TOLERANCE, "HalfBandDecimator");
+    dsp::taps::free(taps);
+    return err;
+}
+
+void addMultirateCases(std::vector<BenchCase>& cases) {
+    // Decimation by two stages of the plans, through the dedicated kernel and the generic one
+    for (auto& [name, len, planTaps] : std::vector<std::tuple<std::string, int, const float*>>{ { "2_2", dsp::multirate::decim::fir_2_2_len, dsp::multirate::decim::fir_2_2_taps }, { "4_2", dsp::multirate::decim::fir_4_2_len, dsp::multirate::decim::fir_4_2_taps } }) {
+        cases.push_back({ "HalfBandDecimator", { { "stage", name } }, 61.44e6, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::tap<float> taps = dsp::taps::fromArray<float>(len, planTaps);
+            dsp::multirate::HalfBandDecimator<dsp::complex_t> decim(&in, taps);
+            double sps = measure(in, decim, durationMs, bufferSize);
+            dsp::taps::free(taps);
+            return sps;
+        }, NULL, [=]() { return checkHalfBandDecimator(len, planTaps); } });
+        cases.push_back({ "DecimatingFIR", { { "stage", name } }, 61.44e6, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::tap<float> taps = dsp::taps::fromArray<float>(len, planTaps);
+            dsp::filter::DecimatingFIR<dsp::complex_t, float> decim(&in, taps, 2);
+            double sps = measure(in, decim, durationMs, bufferSize);
+            dsp::taps::free(taps);
+            return sps;
+        } });
+    }
+
+    for (double samplerate : { 2.4e6, 10e6 }) {
+        for (int ratio : { 2, 4, 8, 16, 32, 64 }) {
+            cases.push_back({ "PowerDecimator", { { "ratio", ratio } }, samplerate, [=](int durationMs, int bufferSize) {
+                dsp::stream<dsp::complex_t> in;
+                dsp::multirate::PowerDecimator<dsp::complex_t> decim(&in, ratio);
+                return measure(in, decim, durationMs, bufferSize);
+            } });
+            cases.push_back({ "PowerDecimator", { { "ratio", ratio }, { "input", "int16" } }, samplerate, [=](int durationMs, int bufferSize) {
+                dsp::stream<dsp::complex16_t> in;
+                dsp::multirate::PowerDecimator<dsp::complex_t, dsp::complex16_t> decim(&in, ratio);
+                return measure(in, decim, durationMs, bufferSize);
+            } });
+        }
+
+        // Ratios without a precomputed plan
+        for (int ratio : { 3, 5, 6, 10, 12, 24, 40 }) {
+            cases.push_back({ "PowerDecimator", { { "ratio", ratio }, { "plan", "generated" } }, samplerate, [=](int durationMs, int bufferSize) {
+                dsp::stream<dsp::complex_t> in;
+                dsp::multirate::PowerDecimator<dsp::complex_t> decim(&in, ratio);
+                return measure(in, decim, durationMs, bufferSize);
+            } });
+        }
+    }
+
+    std::vector<std::pair<double, double>> rates = { { 2.4e6, 250e3 }, { 250e3, 48e3 }, { 48e3, 44.1e3 }, { 44.1e3, 48e3 } };
+    for (auto& [inSr, outSr] : rates) {
+        cases.push_back({ "RationalResampler", { { "type", "complex" }, { "outSamplerate", outSr } }, inSr, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::multirate::RationalResampler<dsp::complex_t> resamp(&in, inSr, outSr);
+            return measure(in, resamp, durationMs, bufferSize);
+        } });
+        cases.push_back({ "RationalResampler", { { "type", "float" }, { "outSamplerate", outSr } }, inSr, [=](int durationMs, int bufferSize) {
+            dsp::stream<float> in;
+            dsp::multirate::RationalResampler<float> resamp(&in, inSr, outSr);
+            return measure(in, resamp, durationMs, bufferSize);
+        } });
+    }
+}
+
+void addChannelCases(std::vector<BenchCase>& cases) {
+    struct VFOParams { double inSr, outSr, bandwidth; };
+    for (auto& p : std::vector<VFOParams>{ { 2.4e6, 50e3, 12.5e3 }, { 2.4e6, 250e3, 200e3 }, { 10e6, 50e3, 12.5e3 }, { 10e6, 250e3, 200e3 } }) {
+        cases.push_back({ "RxVFO", { { "outSamplerate", p.outSr }, { "bandwidth", p.bandwidth } }, p.inSr, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::channel::RxVFO vfo(&in, p.inSr, p.outSr, p.bandwidth, 100e3);
+            return measure(in, vfo, durationMs, bufferSize);
+        } });
+    }
+
+    // A single output is enough, the filter bank and FFT cost the same for any number of them
+    for (int channels : { 16, 64 }) {
+        cases.push_back({ "PFBChannelizer", { { "channels", channels } }, 10e6, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::stream<dsp::complex_t> out;
+            dsp::channel::PFBChannelizer chan(&in, channels, 10e6);
+            chan.bindStream(&out, 100e3);
+            dsp::bench::SpeedTester<dsp::complex_t, dsp::complex_t> tester(&in, &out);
+            chan.start();
+            double sps = tester.benchmark(durationMs, bufferSize);
+            chan.stop();
+            return sps;
+        }, NULL, [=]() {
+            return checkPFBChannelizer(channels, 10e6);
+        } });
+    }
+
+    cases.push_back({ "FrequencyXlator", {}, 2.4e6, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::channel::FrequencyXlator xlator(&in, 100e3, 2.4e6);
+        return measure(in, xlator, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "DCBlocker", {}, 2.4e6, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::correction::DCBlocker<dsp::complex_t> dcBlock(&in, 50.0, 2.4e6);
+        return measure(in, dcBlock, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "NoiseBlanker", {}, 250e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::noise_reduction::NoiseBlanker nb(&in, 500.0 / 250e3, 10.0);
+        return measure(in, nb, durationMs, bufferSize);
+    } });
+
+    for (int bins : { 8, 32 }) {
+        for (int hop : { 1, 2, 4, 8, 16 }) {
+            cases.push_back({ "FMIF", { { "bins", bins }, { "hop", hop } }, 250e3, [=](int durationMs, int bufferSize) {
+                dsp::stream<dsp::complex_t> in;
+                dsp::noise_reduction::FMIF fmnr(&in, bins, hop);
+                return measure(in, fmnr, durationMs, bufferSize);
+            }, [=]() {
+                return json{ { "audioSnrDb", fmifAudioSNR(bins, hop) }, { "audioSnrNoNRDb", fmifAudioSNR(0, 0) } };
+            } });
+        }
+    }
+}
+
+void addDemodCases(std::vector<BenchCase>& cases) {
+    for (bool stereo : { false, true }) {
+        cases.push_back({ "BroadcastFM", { { "stereo", stereo } }, 250e3, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::demod::BroadcastFM demod(&in, 75e3, 250e3, stereo, true);
+            return measure(in, demod, durationMs, bufferSize);
+        } });
+    }
+
+    for (auto& [name, accuracy] : std::vector<std::pair<std::string, dsp::demod::Quadrature::Accuracy>>{ { "exact", dsp::demod::Quadrature::EXACT }, { "high", dsp::demod::Quadrature::HIGH }, { "fast", dsp::demod::Quadrature::FAST } }) {
+        cases.push_back({ "Quadrature", { { "accuracy", name } }, 250e3, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::demod::Quadrature demod(&in, 75e3, 250e3);
+            demod.setAccuracy(accuracy);
+            return measure(in, demod, durationMs, bufferSize);
+        } });
+    }
+
+    cases.push_back({ "FM", {}, 50e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::FM<float> demod;
+        demod.init(&in, 50e3, 12.5e3, true, false);
+        return measure(in, demod, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "AM", {}, 15e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::AM<float> demod(&in, dsp::demod::AM<float>::AGCMode::CARRIER, 10e3, 50.0 / 15e3, 5.0 / 15e3, 100.0 / 15e3, 15e3);
+        return measure(in, demod, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "SSB", {}, 24e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::SSB<float> demod(&in, dsp::demod::SSB<float>::Mode::USB, 2.8e3, 24e3, 50.0 / 24e3, 5.0 / 24e3);
+        return measure(in, demod, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "PSK", { { "order", 4 } }, 150e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::demod::PSK<4> demod(&in, 72e3, 150e3, 31, 0.6, 1e-3, 0.005, 1e-6, 0.01);
+        return measure(in, demod, durationMs, bufferSize);
+    } });
+}
+
+// The AGC as it was before the peaks were computed in one pass, scanning the look-ahead again for every clipping sample
+std::vector<float> referenceAGC(const std::vector<float>& in, const int* blocks, int blockCount, float setPoint, float attack, float decay, float maxGain, float maxOutputAmp, int lookAhead) {
+    std::vector<float> out(in.size());
+    float amp = setPoint;
+    int start = 0;
+    for (int b = 0; b < blockCount; b++) {
+        int end = start + blocks[b];
+        for (int i = start; i < end; i++) {
+            float inAmp = fabsf(in[i]);
+            float gain = 1.0f;
+            if (inAmp != 0.0f) {
+                amp = (inAmp > amp) ? ((amp * (1.0f - attack)) + (inAmp * attack)) : ((amp * (1.0f - decay)) + (inAmp * decay));
+                gain = std::min<float>(setPoint / amp, maxGain);
+            }
+            if (inAmp * gain > maxOutputAmp) {
+                int last = (lookAhead > 0) ? std::min<int>(i + lookAhead, end) : end;
+                amp = 0.0f;
+                for (int j = i; j < last; j++) { amp = std::max<float>(amp, fabsf(in[j])); }
+                gain = std::min<float>(setPoint / amp, maxGain);
+            }
+            out[i] = in[i] * gain;
+        }
+        start = end;
+    }
+    return out;
+}
+
+std::string checkAGCLookAhead(int lookAhead) {
+    const int blockCount = sizeof(firCheckBlockSizes) / sizeof(int);
+    int total = 0;
+    for (int count : firCheckBlockSizes) { total += count; }
+
+    // Noise with bursts loud enough to clip, some shorter and some longer than the look-ahead
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise(0.0f, 0.1f);
+    std::uniform_int_distribution<int> burst(0, 2000);
+    std::vector<float> in(total);
+    float level = 1.0f;
+    for (auto& s : in) {
+        if (!burst(rng)) { level = (level == 1.0f) ? 50.0f : 1.0f; }
+        s = noise(rng) * level;
+    }
+
+    const float attack = 50.0f / 48e3f;
+    const float decay = 5.0f / 48e3f;
+    std::vector<float> ref = referenceAGC(in, firCheckBlockSizes, blockCount, 1.0f, attack, decay, 10e6f, 0.5f, lookAhead);
+
+    dsp::loop::AGC<float> agc(NULL, 1.0, attack, decay, 10e6, 0.5);
+    agc.setLookAhead(lookAhead);
+    std::vector<float> out = in;
+    int start = 0;
+    for (int count : firCheckBlockSizes) {
+        agc.process(count, &out[start], &out[start]);
+        start += count;
+    }
+    for (int i = 0; i < total; i++) {
+        if (!(fabsf(out[i] - ref[i]) <= 1e-6f * fabsf(ref[i]))) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "sample %d is %g instead of %g", i, out[i], ref[i]);
+            return buf;
+        }
+    }
+    return "";
+}
+
+void addLoopCases(std::vector<BenchCase>& cases) {
+    // An output limit below the input amplitude makes the AGC clip all the time
+    for (double maxOutputAmp : { 10.0, 0.5 }) {
+        cases.push_back({ "AGC", { { "type", "float" }, { "maxOutputAmp", maxOutputAmp } }, 48e3, [=](int durationMs, int bufferSize) {
+            dsp::stream<float> in;
+            dsp::loop::AGC<float> agc(&in, 1.0, 50.0 / 48e3, 5.0 / 48e3, 10e6, maxOutputAmp);
+            return measure(in, agc, durationMs, bufferSize);
+        } });
+        cases.push_back({ "AGC", { { "type", "complex" }, { "maxOutputAmp", maxOutputAmp } }, 250e3, [=](int durationMs, int bufferSize) {
+            dsp::stream<dsp::complex_t> in;
+            dsp::loop::AGC<dsp::complex_t> agc(&in, 1.0, 50.0 / 250e3, 5.0 / 250e3, 10e6, maxOutputAmp);
+            return measure(in, agc, durationMs, bufferSize);
+        } });
+    }
+
+    for (int lookAhead : { 0, 1, 7, 64, 1000 }) {
+        BenchCase bc = { "AGC", { { "type", "float" }, { "lookAhead", lookAhead } }, 48e3, NULL };
+        bc.check = [=]() { return checkAGCLookAhead(lookAhead); };
+        cases.push_back(bc);
+    }
+
+    cases.push_back({ "FastAGC", { { "type", "complex" } }, 250e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::FastAGC<dsp::complex_t> agc(&in, 1.0, 10e6, 1e-3);
+        return measure(in, agc, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "Costas", { { "order", 2 } }, 150e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::Costas<2> costas(&in, 0.005);
+        return measure(in, costas, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "Costas", { { "order", 4 } }, 150e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::loop::Costas<4> costas(&in, 0.005);
+        return measure(in, costas, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "MM", { { "type", "float" } }, 150e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<float> in;
+        dsp::clock_recovery::MM<float> mm(&in, 150e3 / 72e3, 1e-6, 0.01, 0.01);
+        return measure(in, mm, durationMs, bufferSize);
+    } });
+
+    cases.push_back({ "MM", { { "type", "complex" } }, 150e3, [=](int durationMs, int bufferSize) {
+        dsp::stream<dsp::complex_t> in;
+        dsp::clock_recovery::MM<dsp::complex_t> mm(&in, 150e3 / 72e3, 1e-6, 0.01, 0.01);
+        return measure(in, mm, durationMs, bufferSize);
+    } });
+}
+
+int main(int argc, char* argv[]) {
+    CommandArgsParser args;
+    args.define('h', "help", "Show help");
+    args.define('l', "list", "List the benchmarks without running them");
+    args.define('d', "duration", "Duration of each benchmark in milliseconds", 500);
+    args.define('f', "filter", "Only run benchmarks of blocks whose name contains this string", "");
+    args.define('o', "output", "File to write the JSON results to, '-' for stdout", "sdrpp_bench.json");
+    args.define('\0', "lock-free", "Use lock-free streams");
+    args.define('\0', "scheduler", "Run blocks on the shared worker pool");
+    args.define('c', "check", "Only run the correctness checks, the exit status is nonzero if any fails");
+    if (args.parse(argc, argv) < 0) { return -1; }
+    if (args["help"].b()) {
+        args.showHelp();
+        return 0;
+    }
+
+    int durationMs = args["duration"];
+    std::string filter = args["filter"];
+    std::string output = args["output"];
+    bool lockFree = args["lock-free"];
+    bool scheduler = args["scheduler"];
+    if (lockFree) { dsp::setDefaultStreamMode(dsp::STREAM_MODE_LOCK_FREE); }
+    if (scheduler) { dsp::scheduler::init(); }
+    dsp::kernels::init();
+
+    std::vector<BenchCase> cases;
+    addFilterCases(cases);
+    addMultirateCases(cases);
+    addChannelCases(cases);
+    addDemodCases(cases);
+    addLoopCases(cases);
+    addKernelCases(cases);
+    addTapCases(cases);
+    addSpectrumCases(cases);
+
+    if (args["check"].b()) {
+        int failed = 0;
+        for (auto& bc : cases) {
+            if (!bc.check || (!filter.empty() && bc.block.find(filter) == std::string::npos)) { continue; }
+            std::string err = bc.check();
+            if (err.empty()) {
+                printf("PASS %s %s\n", bc.block.c_str(), bc.params.dump().c_str());
+                continue;
+            }
+            printf("FAIL %s %s: %s\n", bc.block.c_str(), bc.params.dump().c_str(), err.c_str());
+            failed++;
+        }
+        return failed ? 1 : 0;
+    }
+
+    json results = json::array();
+    for (auto& bc : cases) {
+        // Some cases are only checked
+        if (!bc.run || (!filter.empty() && bc.block.find(filter) == std::string::npos)) { continue; }
+
+        // Buffer sizes must leave room for interpolating blocks
+        double interp = bc.params.contains("outSamplerate") ? (double)bc.params["outSamplerate"] / bc.samplerate : 1.0;
+        int bufferSize = getBufferSize(bc.samplerate, interp);
+
+        if (args["list"].b()) {
+            printf("%s %s\n", bc.block.c_str(), bc.params.dump().c_str());
+            continue;
+        }
+
+        // Progress goes to stderr so that stdout can be used for the results
+        fprintf(stderr, "%s %s... ", bc.block.c_str(), bc.params.dump().c_str());
+        double sps = bc.run(durationMs, bufferSize);
+        fprintf(stderr, "%.3f MS/s", sps * 1e-6);
+        json quality = bc.quality ? bc.quality() : json();
+        if (!quality.is_null()) { fprintf(stderr, " %s", quality.dump().c_str()); }
+        fprintf(stderr, "\n");
+
+        json res;
+        res["block"] = bc.block;
+        res["params"] = bc.params.is_null() ? json::object() : bc.params;
+        res["samplerate"] = bc.samplerate;
+        res["bufferSize"] = bufferSize;
+        res["samplesPerSecond"] = sps;
+        res["msps"] = sps * 1e-6;
+        res["nsPerSample"] = (sps > 0.0) ? (1e9 / sps) : 0.0;
+        if (!quality.is_null()) { res["quality"] = quality; }
+        results.push_back(res);
+    }
+    if (args["list"].b()) { return 0; }
+
+    json report;
+    report["durationMs"] = durationMs;
+    report["lockFreeStreams"] = lockFree;
+    report["scheduler"] = scheduler;
+    report["schedulerThreads"] = scheduler ? dsp::scheduler::getThreadCount() : 0;
+    report["results"] = results;
+
+    if (output == "-") {
+        printf("%s\n", report.dump(4).c_str());
+        return 0;
+    }
+    std::ofstream file(output);
+    if (!file.is_open()) {
+        fprintf(stderr, "Could not open '%s' for writing\n", output.c_str());
+        return -1;
+    }
+    file << report.dump(4);
+    return 0;
+}
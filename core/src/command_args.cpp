@@ -19,6 +19,7 @@ void CommandArgsParser::defineAll() {
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
         define('\0', "autostart", "Automatically start the SDR after loading");
+        define('\0', "thread_policy", "DSP thread CPU and priority rules, e.g. \"VFO *=cpus:4-7 fifo:40; IQ Splitter=cpus:2,3 nice:-5\"", "");
 }
 
 int CommandArgsParser::parse(int argc, char* argv[]) {
@@ -19,6 +19,10 @@
 #include <stb_image_resize.h>
 #include <gui/gui.h>
 #include <signal_path/signal_path.h>
+#include <dsp/stream.h>
+#include <dsp/threading.h>
+#include <dsp/fft/plan.h>
+#include <dsp/kernels/kernels.h>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -125,7 +129,13 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["fftHeight"] = 300;
     defConfig["fftRate"] = 20;
     defConfig["fftSize"] = 65536;
+    defConfig["fftThreads"] = 0;
     defConfig["fftWindow"] = 2;
+    defConfig["fftAverages"] = 1;
+    defConfig["fftOverlap"] = 50;
+    defConfig["fftReduce"] = false;
+    defConfig["fftReduceMode"] = 0;
+    defConfig["fftZoom"] = true;
     defConfig["frequency"] = 100000000.0;
     defConfig["fullWaterfallUpdate"] = false;
     defConfig["max"] = 0.0;
@@ -249,6 +259,13 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["decimation"] = 1;
     defConfig["iqCorrection"] = false;
     defConfig["invertIQ"] = false;
+    defConfig["lockFreeStreams"] = false;
+    defConfig["streamSlots"] = STREAM_DEFAULT_SLOTS;
+    defConfig["dspScheduler"] = false;
+    defConfig["dspSchedulerThreads"] = 0;
+    defConfig["dspProfilerLogInterval"] = 0;
+    defConfig["fftPlanEffort"] = "measure";
+    defConfig["dspThreadPolicy"] = json::array();
 
     defConfig["streams"]["Radio"]["muted"] = false;
     defConfig["streams"]["Radio"]["sink"] = "Audio";
@@ -354,6 +371,65 @@ int sdrpp_main(int argc, char* argv[]) {
     // Load UI scaling
     style::uiScale = core::configManager.conf["uiScale"];
 
+    // Select the DSP stream implementation before any stream gets used
+    if (core::configManager.conf["lockFreeStreams"]) {
+        dsp::setDefaultStreamMode(dsp::STREAM_MODE_LOCK_FREE, core::configManager.conf["streamSlots"]);
+    }
+
+    // Pin DSP threads to CPUs and raise their priority, rules from the command line take precedence
+    if (!dsp::threading::parseRules(core::args["thread_policy"].s())) {
+        flog::error("Ignoring the rest of the thread policies given on the command line");
+    }
+    for (auto& rule : core::configManager.conf["dspThreadPolicy"]) {
+        // Rules with fields of the wrong type or out of range are skipped, the same as on the command line
+        if (!rule.is_object() || !rule.contains("match") || !rule["match"].is_string()) {
+            flog::error("Ignoring a thread policy without a match pattern: {0}", rule.dump());
+            continue;
+        }
+        std::string match = rule["match"];
+        dsp::threading::Policy policy;
+        if (rule.contains("cpus") && (!rule["cpus"].is_string() || !dsp::threading::parseCPUList(rule["cpus"], policy.cpus))) {
+            flog::error("Invalid CPU list in the thread policy for '{0}', it must be a string like \"0-3,6\"", match);
+            continue;
+        }
+        if (rule.contains("fifo")) {
+            if (!rule["fifo"].is_number_integer() || (int)rule["fifo"] < 1 || (int)rule["fifo"] > 99) {
+                flog::error("Invalid SCHED_FIFO priority in the thread policy for '{0}', it must be from 1 to 99", match);
+                continue;
+            }
+            policy.fifoPriority = rule["fifo"];
+        }
+        if (rule.contains("nice")) {
+            if (!rule["nice"].is_number_integer() || (int)rule["nice"] < -20 || (int)rule["nice"] > 19) {
+                flog::error("Invalid nice value in the thread policy for '{0}', it must be from -20 to 19", match);
+                continue;
+            }
+            policy.setNice = true;
+            policy.nice = rule["nice"];
+        }
+        dsp::threading::addRule(match, policy);
+    }
+
+    // Use the best variants of the DSP kernels this CPU can run
+    dsp::kernels::init();
+
+    // Measure FFT plans in the background and keep what was learned across runs
+    dsp::fft::Effort fftEffort;
+    if (!dsp::fft::parseEffort(core::configManager.conf["fftPlanEffort"], fftEffort)) {
+        flog::error("Unknown FFT plan effort '{0}', using estimates", (std::string)core::configManager.conf["fftPlanEffort"]);
+        fftEffort = dsp::fft::EFFORT_ESTIMATE;
+    }
+    dsp::fft::init(root + "/fftw_wisdom", fftEffort);
+
+    // Run DSP blocks on a shared worker pool instead of one thread each
+    if (core::configManager.conf["dspScheduler"]) {
+        dsp::scheduler::init(core::configManager.conf["dspSchedulerThreads"]);
+        flog::info("DSP scheduler started with {0} threads", dsp::scheduler::getThreadCount());
+    }
+
+    // Periodically log the CPU usage of every DSP block
+    dsp::perf::setLogInterval(core::configManager.conf["dspProfilerLogInterval"]);
+
     core::configManager.release(true);
 
     if (serverMode) { return server::main(); }
@@ -412,6 +488,8 @@ int sdrpp_main(int argc, char* argv[]) {
 
     sigpath::iqFrontEnd.stop();
 
+    dsp::fft::end();
+
     core::configManager.disableAutoSave();
     core::configManager.save();
 #endif
@@ -2,8 +2,12 @@
 #include <assert.h>
 #include <thread>
 #include <vector>
+#include <string>
 #include <algorithm>
 #include "stream.h"
+#include "scheduler.h"
+#include "perf.h"
+#include "threading.h"
 #include "types.h"
 
 namespace dsp {
@@ -16,6 +20,9 @@ namespace dsp {
     };
 
     class block : public generic_block {
+        friend scheduler::Pool;
+        friend std::vector<perf::BlockStats> perf::getStats();
+        friend void perf::resetStats();
     public:
         virtual ~block() {
             if (!_block_init) { return; }
@@ -63,16 +70,59 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Name shown by the profiler and given to the block's threads instead of the type name. The profiler and the worker
+        // threads read it without locking, so it can only be set while the block is stopped.
+        void setPerfName(std::string name) {
+            assert(!running);
+            perfName = name;
+        }
+
+        std::string getPerfName() {
+            return perfName;
+        }
+
+        std::atomic<uint64_t> perfRuns = 0;
+        std::atomic<uint64_t> perfRunTime = 0;
+
     protected:
+        inline int timedRun() {
+            uint64_t start = perf::now();
+            int ret = run();
+            perfRunTime.fetch_add(perf::now() - start, std::memory_order_relaxed);
+            perfRuns.fetch_add(1, std::memory_order_relaxed);
+            return ret;
+        }
+
+        // Name the block's threads are set up with, blocks with more than one thread add a suffix to the others
+        std::string getThreadName() {
+            return perfName.empty() ? perf::getTypeName(this) : perfName;
+        }
+
         void workerLoop() {
-            while (run() >= 0) {}
+            threading::setupCurrentThread(getThreadName());
+            while (timedRun() >= 0) {}
         }
 
         virtual void doStart() {
+            perf::registerBlock(this);
+
+            // Blocks without inputs have nothing to wait on and keep their own thread
+            if (scheduler::isEnabled() && !inputs.empty()) {
+                scheduled = true;
+                scheduler::attach(this);
+                return;
+            }
             workerThread = std::thread(&block::workerLoop, this);
         }
 
         virtual void doStop() {
+            perf::unregisterBlock(this);
+
+            // Make sure the scheduler doesn't queue the block again while it's being stopped
+            if (scheduled) {
+                scheduler::detach(this);
+            }
+
             for (auto& in : inputs) {
                 in->stopReader();
             }
@@ -80,6 +130,11 @@ namespace dsp {
                 out->stopWriter();
             }
 
+            if (scheduled) {
+                scheduler::waitIdle(this);
+                scheduled = false;
+            }
+
             // TODO: Make sure this isn't needed, I don't know why it stops
             if (workerThread.joinable()) {
                 workerThread.join();
@@ -128,5 +183,13 @@ namespace dsp {
         bool tempStopped = false;
         int tempStopDepth = 0;
         std::thread workerThread;
+        std::string perfName;
+
+        // Scheduler state
+        bool scheduled = false;
+        std::atomic<bool> schedAttached = false;
+        std::atomic<int> schedState = 0;
+        std::mutex schedMtx;
+        std::condition_variable schedCV;
     };
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include <algorithm>
+#include "buffer.h"
+
+namespace dsp::buffer {
+    // Returns true if the two memory areas share at least one byte
+    inline bool overlaps(const void* a, size_t aBytes, const void* b, size_t bBytes) {
+        return ((const char*)a < (const char*)b + bBytes) && ((const char*)b < (const char*)a + aBytes);
+    }
+
+    // History of the last samples seen by a filter. Filters read windows of length + 1 samples, position 0 being the oldest
+    // history sample. Instead of copying every input block after the history, only the first samples of the block are joined
+    // to it, windows starting further in are read from the block directly.
+    // The history for the next block is saved when the block starts, so the output may overwrite the block as long as it
+    // doesn't overwrite samples that windows yet to be read still need.
+    template <class T>
+    class DelayLine {
+    public:
+        DelayLine() {}
+
+        DelayLine(int length) { init(length); }
+
+        ~DelayLine() {
+            if (!junction) { return; }
+            buffer::free(junction);
+            buffer::free(next);
+            if (spillBuf) { buffer::free(spillBuf); }
+        }
+
+        // Not copyable, the buffers are owned
+        DelayLine(const DelayLine&) = delete;
+        DelayLine& operator=(const DelayLine&) = delete;
+
+        void init(int length) {
+            _length = length;
+            capacity = std::max<int>(length, 1);
+            junction = buffer::alloc<T>(2 * capacity);
+            next = buffer::alloc<T>(2 * capacity);
+            clear();
+        }
+
+        // Change the length, keeping the newest samples. Older samples that are added are zeros.
+        void setLength(int length) {
+            if (length > capacity) {
+                T* newJunction = buffer::alloc<T>(2 * length);
+                buffer::clear(newJunction, length - _length);
+                memcpy(&newJunction[length - _length], junction, _length * sizeof(T));
+                buffer::free(junction);
+                buffer::free(next);
+                junction = newJunction;
+                next = buffer::alloc<T>(2 * length);
+                capacity = length;
+            }
+            else if (length > _length) {
+                memmove(&junction[length - _length], junction, _length * sizeof(T));
+                buffer::clear(junction, length - _length);
+            }
+            else if (length < _length) {
+                memmove(junction, &junction[_length - length], length * sizeof(T));
+            }
+            _length = length;
+        }
+
+        inline int getLength() {
+            return _length;
+        }
+
+        void clear() {
+            buffer::clear(junction, _length);
+        }
+
+        // Start filtering a block, it must stay readable until end() is called
+        inline void begin(const T* in, int count) {
+            _in = in;
+
+            // Save what will be the history after this block before the output gets a chance to overwrite it
+            if (count >= _length) {
+                memcpy(next, &in[count - _length], _length * sizeof(T));
+            }
+            else {
+                memcpy(next, &junction[count], (_length - count) * sizeof(T));
+                memcpy(&next[_length - count], in, count * sizeof(T));
+            }
+
+            // Join the start of the block to the history
+            memcpy(&junction[_length], in, std::min<int>(count, _length) * sizeof(T));
+        }
+
+        // Window of length + 1 contiguous samples starting at pos, for pos between 0 and the block size - 1
+        inline const T* window(int pos) {
+            return (pos < _length) ? &junction[pos] : &_in[pos - _length];
+        }
+
+        // Copy len samples starting at pos, which may not go past the end of the block
+        inline void read(T* dst, int pos, int len) {
+            if (pos < _length) {
+                int n = std::min<int>(len, _length - pos);
+                memcpy(dst, &junction[pos], n * sizeof(T));
+                dst += n;
+                pos += n;
+                len -= n;
+            }
+            memcpy(dst, &_in[pos - _length], len * sizeof(T));
+        }
+
+        // Done with the block, the saved history becomes the current one
+        inline void end() {
+            std::swap(junction, next);
+        }
+
+        // Scratch space for outputs that can't be written to the block yet, or for a copy of the block
+        inline T* spill(int count) {
+            if (count > spillCapacity) {
+                if (spillBuf) { buffer::free(spillBuf); }
+                spillBuf = buffer::alloc<T>(count);
+                spillCapacity = count;
+            }
+            return spillBuf;
+        }
+
+    private:
+        int _length = 0;
+        int capacity = 0;
+        T* junction = NULL;
+        T* next = NULL;
+        const T* _in = NULL;
+        T* spillBuf = NULL;
+        int spillCapacity = 0;
+    };
+}
@@ -17,6 +17,8 @@ namespace dsp::buffer {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
+                if (!buffers[i]) { continue; }
+                perf::addBufferMemory(-(int64_t)capacities[i] * sizeof(T));
                 buffer::free(buffers[i]);
             }
         }
@@ -24,9 +26,12 @@ namespace dsp::buffer {
         void init(stream<T>* in) {
             _in = in;
 
+            // Frames are allocated as data comes in, to the size of the blocks actually received
             for (int i = 0; i < TEST_BUFFER_SIZE; i++) {
-                buffers[i] = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+                buffers[i] = NULL;
+                capacities[i] = 0;
             }
+            out.resize(0);
 
             base_type::registerInput(in);
             base_type::registerOutput(&out);
@@ -54,6 +59,7 @@ namespace dsp::buffer {
             if (count < 0) { return -1; }
 
             if (bypass) {
+                out.reserve(count);
                 memcpy(out.writeBuf, _in->readBuf, count * sizeof(T));
                 _in->flush();
                 if (!out.swap(count)) { return -1; }
@@ -63,6 +69,15 @@ namespace dsp::buffer {
             // Push it on the ring buffer
             {
                 std::lock_guard<std::mutex> lck(bufMtx);
+                if (capacities[writeCur] < count) {
+                    if (buffers[writeCur]) {
+                        perf::addBufferMemory(-(int64_t)capacities[writeCur] * sizeof(T));
+                        buffer::free(buffers[writeCur]);
+                    }
+                    buffers[writeCur] = buffer::alloc<T>(count);
+                    capacities[writeCur] = count;
+                    perf::addBufferMemory((int64_t)count * sizeof(T));
+                }
                 memcpy(buffers[writeCur], _in->readBuf, count * sizeof(T));
                 sizes[writeCur] = count;
                 writeCur++;
@@ -74,6 +89,7 @@ namespace dsp::buffer {
         }
 
         void worker() {
+            threading::setupCurrentThread(base_type::getThreadName() + " Output");
             while (true) {
                 // Wait for data
                 std::unique_lock lck(bufMtx);
@@ -82,6 +98,7 @@ namespace dsp::buffer {
 
                 // Write one to output buffer and unlock in preparation to swap buffers
                 int count = sizes[readCur];
+                out.reserve(count);
                 memcpy(out.writeBuf, buffers[readCur], count * sizeof(T));
                 readCur++;
                 readCur = ((readCur) % TEST_BUFFER_SIZE);
@@ -101,11 +118,13 @@ namespace dsp::buffer {
 
     private:
         void doStart() {
+            perf::registerBlock(this);
             base_type::workerThread = std::thread(&SampleFrameBuffer<T>::workerLoop, this);
             readWorkerThread = std::thread(&SampleFrameBuffer<T>::worker, this);
         }
 
         void doStop() {
+            perf::unregisterBlock(this);
             _in->stopReader();
             out.stopWriter();
             stopWorker = true;
@@ -126,6 +145,7 @@ namespace dsp::buffer {
         std::condition_variable cnd;
         T* buffers[TEST_BUFFER_SIZE];
         int sizes[TEST_BUFFER_SIZE];
+        int capacities[TEST_BUFFER_SIZE];
 
         bool stopWorker = false;
     };
@@ -70,16 +70,20 @@ namespace dsp::buffer {
 
     private:
         void doStart() override {
+            perf::registerBlock(this);
+            out.resize(_keep);
             workThread = std::thread(&Reshaper<T>::loop, this);
             bufferWorkerThread = std::thread(&Reshaper<T>::bufferWorker, this);
         }
 
         void loop() {
-            while (run() >= 0)
+            threading::setupCurrentThread(base_type::getThreadName());
+            while (base_type::timedRun() >= 0)
                 ;
         }
 
         void doStop() override {
+            perf::unregisterBlock(this);
             _in->stopReader();
             ringBuf.stopReader();
             out.stopWriter();
@@ -99,26 +103,21 @@ namespace dsp::buffer {
         }
 
         void bufferWorker() {
-            T* buf = new T[_keep];
+            threading::setupCurrentThread(base_type::getThreadName() + " Output");
+            T* buf = new T[_keep]();
             bool delay = _skip < 0;
 
             int readCount = std::min<int>(_keep + _skip, _keep);
             int skip = std::max<int>(_skip, 0);
             int delaySize = (-_skip) * sizeof(T);
-            int delayCount = (-_skip);
 
             T* start = &buf[std::max<int>(-_skip, 0)];
             T* delayStart = &buf[_keep + _skip];
 
             while (true) {
+                // A negative skip overlaps the frames, the end of the previous one starts the next
                 if (delay) {
                     memmove(buf, delayStart, delaySize);
-                    if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                        for (int i = 0; i < delayCount; i++) {
-                            buf[i].re /= 10.0f;
-                            buf[i].im /= 10.0f;
-                        }
-                    }
                 }
                 if (ringBuf.readAndSkip(start, readCount, skip) < 0) { break; };
                 memcpy(out.writeBuf, buf, _keep * sizeof(T));
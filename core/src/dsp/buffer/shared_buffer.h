@@ -0,0 +1,145 @@
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <condition_variable>
+#include "buffer.h"
+#include "../perf.h"
+
+namespace dsp::buffer {
+    template <class T>
+    class SharedBufferPool;
+
+    // Read-only buffer handed to several streams at once, goes back to its pool when the last reader flushes
+    template <class T>
+    class SharedBuffer {
+        friend SharedBufferPool<T>;
+    public:
+        inline void retain() {
+            refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        inline void release() {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) != 1) { return; }
+
+            // If the pool is already gone, the last reader owns the buffer
+            if (!pool) {
+                SharedBufferPool<T>::freeData(this);
+                delete this;
+                return;
+            }
+            pool->recycle(this);
+        }
+
+        T* data;
+
+    private:
+        int capacity = 0;
+        std::atomic<int> refs = 0;
+        SharedBufferPool<T>* pool = NULL;
+    };
+
+    template <class T>
+    class SharedBufferPool {
+        friend SharedBuffer<T>;
+    public:
+        SharedBufferPool() {}
+
+        SharedBufferPool(int bufferSize, int maxBuffers) { init(bufferSize, maxBuffers); }
+
+        ~SharedBufferPool() {
+            std::lock_guard<std::mutex> lck(mtx);
+            for (auto& buf : buffers) {
+                // Buffers still held by a stream will be freed by their last reader
+                if (buf->refs.load()) {
+                    buf->pool = NULL;
+                    continue;
+                }
+                freeData(buf);
+                delete buf;
+            }
+            buffers.clear();
+            freeList.clear();
+        }
+
+        void init(int bufferSize, int maxBuffers) {
+            _bufferSize = bufferSize;
+            _maxBuffers = maxBuffers;
+        }
+
+        // Get an unused buffer of at least the given size with a reference count of one, or NULL if the pool was stopped.
+        // A negative size means the pool's buffer size.
+        SharedBuffer<T>* acquire(int size = -1) {
+            std::unique_lock<std::mutex> lck(mtx);
+            if (size < 0) { size = _bufferSize; }
+
+            // Only allocate new buffers if all existing ones are in use
+            if (freeList.empty() && (int)buffers.size() < _maxBuffers) {
+                SharedBuffer<T>* buf = new SharedBuffer<T>;
+                buf->data = NULL;
+                buf->pool = this;
+                buffers.push_back(buf);
+                freeList.push_back(buf);
+            }
+
+            // Wait for a buffer to be returned
+            cnd.wait(lck, [this]() { return !freeList.empty() || stopped; });
+            if (stopped) { return NULL; }
+
+            SharedBuffer<T>* buf = freeList.back();
+            freeList.pop_back();
+            buf->refs.store(1, std::memory_order_relaxed);
+
+            // Nobody else holds a free buffer, so it can be grown in place
+            if (buf->capacity < size) {
+                freeData(buf);
+                buf->data = buffer::alloc<T>(size);
+                buf->capacity = size;
+                perf::addBufferMemory((int64_t)size * sizeof(T));
+            }
+            return buf;
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                stopped = true;
+            }
+            cnd.notify_all();
+        }
+
+        void clearStop() {
+            std::lock_guard<std::mutex> lck(mtx);
+            stopped = false;
+        }
+
+        int getBufferSize() {
+            return _bufferSize;
+        }
+
+    private:
+        static void freeData(SharedBuffer<T>* buf) {
+            if (!buf->data) { return; }
+            perf::addBufferMemory(-(int64_t)buf->capacity * sizeof(T));
+            buffer::free(buf->data);
+            buf->data = NULL;
+            buf->capacity = 0;
+        }
+
+        void recycle(SharedBuffer<T>* buf) {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                freeList.push_back(buf);
+            }
+            cnd.notify_all();
+        }
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::vector<SharedBuffer<T>*> buffers;
+        std::vector<SharedBuffer<T>*> freeList;
+        int _bufferSize = 0;
+        int _maxBuffers = 0;
+        bool stopped = false;
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+
+namespace dsp::buffer {
+    // Lock-free handoff of a value from one writer thread to one reader thread. The writer fills back() and publishes it,
+    // the reader picks up the latest published value with update() and keeps using front() until the next update.
+    // Values published in between are skipped, so the value must hold the whole state and not a change to it.
+    template <class T>
+    class TripleBuffer {
+    public:
+        // Writer side
+        inline T& back() {
+            return slots[backId];
+        }
+
+        inline void publish() {
+            backId = state.exchange(backId | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+
+        // Reader side, returns true if a new value was published since the last update
+        inline bool update() {
+            if (!(state.load(std::memory_order_acquire) & DIRTY)) { return false; }
+            frontId = state.exchange(frontId, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        inline T& front() {
+            return slots[frontId];
+        }
+
+        // Direct access to all slots, only allowed while neither side is using the buffer
+        inline T& operator[](int id) {
+            return slots[id];
+        }
+
+        static const int SLOT_COUNT = 3;
+
+    private:
+        static const int INDEX_MASK = 3;
+        static const int DIRTY = 4;
+
+        T slots[SLOT_COUNT] = {};
+        int backId = 0;
+        int frontId = 1;
+        std::atomic<int> state = 2;
+    };
+}
@@ -2,6 +2,7 @@
 #include <vector>
 #include <map>
 #include "processor.h"
+#include "fused_processor.h"
 
 namespace dsp {
     template<class T>
@@ -11,6 +12,10 @@ namespace dsp {
 
         chain(stream<T>* in) { init(in); }
 
+        ~chain() {
+            freeSegments();
+        }
+
         void init(stream<T>* in) {
             _in = in;
             out = _in;
@@ -19,6 +24,15 @@ namespace dsp {
         template<typename Func>
         void setInput(stream<T>* in, Func onOutputChange) {
             _in = in;
+            if (fused) {
+                if (!elements.empty()) {
+                    elements[0]->setInput(_in);
+                    return;
+                }
+                out = _in;
+                onOutputChange(out);
+                return;
+            }
             for (auto& ln : links) {
                 if (states[ln]) {
                     ln->setInput(_in);
@@ -38,6 +52,7 @@ namespace dsp {
             // Add to the list
             links.push_back(block);
             states[block] = false;
+            fusable[block] = block->canFuse();
 
             // Enable if needed
             if (enabled) { enableBlock(block, [](stream<T>* out){}); }
@@ -55,6 +70,7 @@ namespace dsp {
         
             // Remove block from the list
             states.erase(block);
+            fusable.erase(block);
             links.erase(std::find(links.begin(), links.end(), block));
         }
 
@@ -68,6 +84,13 @@ namespace dsp {
             // If already enable, don't do anything
             if (states[block]) { return; }
 
+            // In fused mode, the whole chain gets rebuilt
+            if (fused) {
+                states[block] = true;
+                relink(onOutputChange);
+                return;
+            }
+
             // Gather blocks before and after the block to enable
             Processor<T, T>* before = blockBefore(block);
             Processor<T, T>* after = blockAfter(block);
@@ -99,6 +122,13 @@ namespace dsp {
             // If already disabled, don't do anything
             if (!states[block]) { return; }
 
+            // In fused mode, the whole chain gets rebuilt
+            if (fused) {
+                states[block] = false;
+                relink(onOutputChange);
+                return;
+            }
+
             // Stop disabled block
             block->stop();
             states[block] = false;
@@ -141,8 +171,60 @@ namespace dsp {
             }
         }
 
+        // In fused mode, consecutive enabled blocks that can be fused run from a single thread
+        template<typename Func>
+        void setFused(bool enabled, Func onOutputChange, int chunkSize = FUSED_DEFAULT_CHUNK_SIZE) {
+            if (fused == enabled && _chunkSize == chunkSize) { return; }
+            _chunkSize = chunkSize;
+
+            // Go back to one thread per block if disabling
+            if (!enabled) {
+                bool wasRunning = running;
+                stop();
+                fused = false;
+                elements.clear();
+                stream<T>* last = _in;
+                for (auto& ln : links) {
+                    ln->setFused(false);
+                    if (!states[ln]) { continue; }
+                    ln->setInput(last);
+                    last = &ln->out;
+                }
+                if (out != last) {
+                    out = last;
+                    onOutputChange(out);
+                }
+
+                // Only delete the segments once nothing reads from them anymore
+                freeSegments();
+                if (wasRunning) { start(); }
+                return;
+            }
+
+            bool wasRunning = running;
+            stop();
+            fused = true;
+            relink(onOutputChange);
+            if (wasRunning) { start(); }
+        }
+
+        // Opt a block in or out of fused execution, only has an effect for blocks that support it
+        template<typename Func>
+        void setBlockFusable(Processor<T, T>* block, bool enabled, Func onOutputChange) {
+            if (!blockExists(block)) {
+                throw std::runtime_error("[chain] Tried to change fusing of a block that isn't part of the chain");
+            }
+            fusable[block] = enabled && block->canFuse();
+            if (fused) { relink(onOutputChange); }
+        }
+
         void start() {
             if (running) { return; }
+            if (fused) {
+                for (auto& e : elements) { e->start(); }
+                running = true;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->start();
@@ -152,6 +234,11 @@ namespace dsp {
 
         void stop() {
             if (!running) { return; }
+            if (fused) {
+                for (auto& e : elements) { e->stop(); }
+                running = false;
+                return;
+            }
             for (auto& ln : links) {
                 if (!states[ln]) { continue; }
                 ln->stop();
@@ -162,6 +249,63 @@ namespace dsp {
         stream<T>* out;
 
     private:
+        template<typename Func>
+        void relink(Func onOutputChange) {
+            // Everything gets rewired, so stop what's currently running
+            bool wasRunning = running;
+            stop();
+            std::vector<FusedProcessor<T>*> oldSegments = segments;
+            segments.clear();
+            elements.clear();
+
+            // Group consecutive fusable blocks, a group of one is just run normally
+            std::vector<Processor<T, T>*> group;
+            auto flushGroup = [&]() {
+                if (group.size() > 1) {
+                    for (auto& blk : group) { blk->setFused(true); }
+                    FusedProcessor<T>* seg = new FusedProcessor<T>(NULL, group, _chunkSize);
+                    segments.push_back(seg);
+                    elements.push_back(seg);
+                }
+                else if (group.size() == 1) {
+                    elements.push_back(group[0]);
+                }
+                group.clear();
+            };
+            for (auto& ln : links) {
+                ln->setFused(false);
+                if (!states[ln]) { continue; }
+                if (fusable[ln]) {
+                    group.push_back(ln);
+                    continue;
+                }
+                flushGroup();
+                elements.push_back(ln);
+            }
+            flushGroup();
+
+            // Connect the elements together
+            stream<T>* last = _in;
+            for (auto& e : elements) {
+                e->setInput(last);
+                last = &e->out;
+            }
+            if (out != last) {
+                out = last;
+                onOutputChange(out);
+            }
+
+            // Only delete the old segments once nothing reads from them anymore
+            for (auto& seg : oldSegments) { delete seg; }
+
+            if (wasRunning) { start(); }
+        }
+
+        void freeSegments() {
+            for (auto& seg : segments) { delete seg; }
+            segments.clear();
+        }
+
         Processor<T, T>* blockBefore(Processor<T, T>* block) {
             // TODO: This is wrong and must be fixed when I get more time
             for (auto& ln : links) {
@@ -190,6 +334,12 @@ namespace dsp {
         stream<T>* _in;
         std::vector<Processor<T, T>*> links;
         std::map<Processor<T, T>*, bool> states;
+        std::map<Processor<T, T>*, bool> fusable;
         bool running = false;
+
+        bool fused = false;
+        int _chunkSize = FUSED_DEFAULT_CHUNK_SIZE;
+        std::vector<Processor<T, T>*> elements;
+        std::vector<FusedProcessor<T>*> segments;
     };
 }
\ No newline at end of file
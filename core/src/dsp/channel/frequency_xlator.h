@@ -49,10 +49,15 @@ namespace dsp::channel {
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
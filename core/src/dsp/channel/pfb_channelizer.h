@@ -0,0 +1,267 @@
+#pragma once
+#include <vector>
+#include "../fft/plan.h"
+#include "../sink.h"
+#include "../buffer/delay_line.h"
+#include "../buffer/triple_buffer.h"
+#include "../taps/windowed_sinc.h"
+
+// Length of the prototype filter divided by the channel count. The transition band ends up about half a channel wide.
+#define PFB_CHANNELIZER_TAPS_PER_CHANNEL    8
+
+namespace dsp::channel {
+    // Splits the input into evenly spaced channels with one polyphase filter bank and one FFT per output sample, instead
+    // of translating, filtering and decimating the full rate input once per channel.
+    // With M channels, channel k is centered on k * samplerate / M and sampled at twice the spacing, 2 * samplerate / M.
+    // Each bound stream gets the channel nearest to its offset, translated so that the offset ends up at 0 Hz.
+    class PFBChannelizer : public Sink<complex_t> {
+        using base_type = Sink<complex_t>;
+    public:
+        PFBChannelizer() {}
+
+        PFBChannelizer(stream<complex_t>* in, int channels, double samplerate) { init(in, channels, samplerate); }
+
+        ~PFBChannelizer() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            destroyBank();
+        }
+
+        void init(stream<complex_t>* in, int channels, double samplerate) {
+            _channels = channels;
+            _samplerate = samplerate;
+            createBank();
+            delay.init(protoLen - 1);
+            base_type::init(in);
+        }
+
+        void setChannels(int channels, double samplerate) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            destroyBank();
+            _channels = channels;
+            _samplerate = samplerate;
+            createBank();
+            delay.setLength(protoLen - 1);
+            delay.clear();
+            offset = 0;
+            odd = false;
+            commit();
+            base_type::tempStart();
+        }
+
+        inline int getChannels() {
+            return _channels;
+        }
+
+        inline double getChannelRate() {
+            return 2.0 * _samplerate / (double)_channels;
+        }
+
+        // Widest signal that fits in the flat part of a channel wherever its offset lands between two channel centers
+        inline double getMaxBandwidth() {
+            return _samplerate / (2.0 * (double)_channels);
+        }
+
+        void bindStream(stream<complex_t>* stream, double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream isn't already bound
+            if (findOutput(stream) >= 0) {
+                throw std::runtime_error("[PFBChannelizer] Tried to bind stream to that is already bound");
+            }
+
+            // Add to the list
+            base_type::tempStop();
+            base_type::registerOutput(stream);
+            outputs.push_back({ stream, offset });
+            phases.push_back(lv_cmake(1.0f, 0.0f));
+            commit();
+            base_type::tempStart();
+        }
+
+        void unbindStream(stream<complex_t>* stream) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+
+            // Check that the stream is bound
+            int id = findOutput(stream);
+            if (id < 0) {
+                throw std::runtime_error("[PFBChannelizer] Tried to unbind stream to that isn't bound");
+            }
+
+            // Remove from the list
+            base_type::tempStop();
+            outputs.erase(outputs.begin() + id);
+            phases.erase(phases.begin() + id);
+            base_type::unregisterOutput(stream);
+            commit();
+            base_type::tempStart();
+        }
+
+        // Move the frequency translated to 0 Hz in a bound stream, the channel it comes from is switched if needed
+        void setOffset(stream<complex_t>* stream, double offset) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            int id = findOutput(stream);
+            if (id < 0) {
+                throw std::runtime_error("[PFBChannelizer] Tried to set the offset of a stream that isn't bound");
+            }
+            outputs[id].offset = offset;
+            commit();
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Pick up the latest tunings
+            pending.update();
+            std::vector<Tuning>& tunings = pending.front();
+            int maxFrames = count / decim + 1;
+            for (auto& t : tunings) {
+                t.out->reserve(maxFrames);
+            }
+
+            delay.begin(base_type::_in->readBuf, count);
+            int frames = 0;
+            for (; offset < count; offset += decim) {
+                // Weight the last samples with the prototype filter and fold them into a single FFT's worth
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)work, (lv_32fc_t*)delay.window(offset), protoRev, protoLen);
+                memcpy(fftIn, work, _channels * sizeof(complex_t));
+                for (int i = _channels; i < protoLen; i += _channels) {
+                    volk_32f_x2_add_32f((float*)fftIn, (float*)fftIn, (float*)&work[i], 2 * _channels);
+                }
+                plan.execute(fftIn, fftOut);
+
+                // Take the channel of each output, compensating for the position of the window
+                for (auto& t : tunings) {
+                    t.out->writeBuf[frames] = fftOut[t.channel] * t.correction[odd];
+                }
+                odd = !odd;
+                frames++;
+            }
+            offset -= count;
+            delay.end();
+
+            base_type::_in->flush();
+
+            // Translate each output from the center of its channel to its offset
+            if (!frames) { return count; }
+            for (int i = 0; i < (int)tunings.size(); i++) {
+                Tuning& t = tunings[i];
+#if VOLK_VERSION >= 030100
+                volk_32fc_s32fc_x2_rotator2_32fc((lv_32fc_t*)t.out->writeBuf, (lv_32fc_t*)t.out->writeBuf, &t.phaseDelta, &phases[i], frames);
+#else
+                volk_32fc_s32fc_x2_rotator_32fc((lv_32fc_t*)t.out->writeBuf, (lv_32fc_t*)t.out->writeBuf, t.phaseDelta, &phases[i], frames);
+#endif
+                if (!t.out->swap(frames)) { return -1; }
+            }
+
+            return count;
+        }
+
+    protected:
+        struct Output {
+            stream<complex_t>* out;
+            double offset;
+        };
+
+        struct Tuning {
+            stream<complex_t>* out;
+            int channel;
+            complex_t correction[2];
+            lv_32fc_t phaseDelta;
+        };
+
+        int findOutput(stream<complex_t>* stream) {
+            for (int i = 0; i < (int)outputs.size(); i++) {
+                if (outputs[i].out == stream) { return i; }
+            }
+            return -1;
+        }
+
+        // Hand the tuning of all outputs to the DSP thread. The list of outputs only changes while stopped, so the
+        // tunings it picks up always match the phases.
+        void commit() {
+            std::vector<Tuning>& tunings = pending.back();
+            tunings.resize(outputs.size());
+            double spacing = _samplerate / (double)_channels;
+            for (int i = 0; i < (int)outputs.size(); i++) {
+                Tuning& t = tunings[i];
+                t.out = outputs[i].out;
+
+                // Nearest channel, negative frequencies are in the upper half of the FFT
+                int nearest = (int)round(outputs[i].offset / spacing);
+                t.channel = ((nearest % _channels) + _channels) % _channels;
+
+                // The FFT index of the folded window and the decimation by half the channel count
+                // turn into a fixed phase and a sign flip of odd channels on every other output
+                double rads = -2.0 * FL_M_PI * (double)t.channel / (double)_channels;
+                t.correction[0] = { (float)cos(rads), (float)sin(rads) };
+                t.correction[1] = (t.channel & 1) ? t.correction[0] * -1.0f : t.correction[0];
+
+                // What's left is translated at the channel rate
+                double residual = math::hzToRads(outputs[i].offset - (double)nearest * spacing, getChannelRate());
+                t.phaseDelta = lv_cmake((float)cos(-residual), (float)sin(-residual));
+            }
+            pending.publish();
+        }
+
+        void createBank() {
+            decim = _channels / 2;
+
+            // Prototype filter flat up to about three quarters of the channel spacing on each side and cut off at the centers
+            // of the neighbouring channels (windowedSinc's cutoff is one-sided). getMaxBandwidth() relies on that passband
+            // being wider than the spacing. It's reversed since the delay line windows are oldest first.
+            protoLen = _channels * PFB_CHANNELIZER_TAPS_PER_CHANNEL;
+            tap<float> proto = taps::windowedSinc<float>(protoLen, _samplerate / (double)_channels, _samplerate, window::nuttall);
+            protoRev = buffer::alloc<float>(protoLen);
+            for (int i = 0; i < protoLen; i++) {
+                protoRev[i] = proto.taps[protoLen - 1 - i];
+            }
+            taps::free(proto);
+
+            work = buffer::alloc<complex_t>(protoLen);
+            fftIn = (complex_t*)fftwf_malloc(_channels * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(_channels * sizeof(complex_t));
+            plan.acquire(_channels, FFTW_FORWARD);
+        }
+
+        void destroyBank() {
+            plan.release();
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            buffer::free(work);
+            buffer::free(protoRev);
+        }
+
+        void doStart() {
+            // Outputs only need to hold what one input block turns into
+            int size = base_type::_in ? (std::min<int>(base_type::_in->getBufferSize(), STREAM_BUFFER_SIZE) / decim + 1) : 0;
+            for (const auto& o : outputs) {
+                o.out->resize(size);
+            }
+            base_type::doStart();
+        }
+
+        int _channels;
+        double _samplerate;
+        int decim;
+        int protoLen;
+        float* protoRev;
+        buffer::DelayLine<complex_t> delay;
+        complex_t* work;
+        complex_t* fftIn;
+        complex_t* fftOut;
+        fft::Plan plan;
+        int offset = 0;
+        bool odd = false;
+
+        std::vector<Output> outputs;
+        std::vector<lv_32fc_t> phases;
+        buffer::TripleBuffer<std::vector<Tuning>> pending;
+    };
+}
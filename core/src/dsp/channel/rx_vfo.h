@@ -1,6 +1,7 @@
 #pragma once
 #include "frequency_xlator.h"
 #include "../multirate/rational_resampler.h"
+#include "../buffer/triple_buffer.h"
 
 namespace dsp::channel {
     class RxVFO : public Processor<complex_t, complex_t> {
@@ -23,57 +24,103 @@ namespace dsp::channel {
             _offset = offset;
             filterNeeded = (_bandwidth != _outSamplerate);
             ftaps.taps = NULL;
+            current = { _inSamplerate, _outSamplerate, _bandwidth, _offset, false };
 
             xlator.init(NULL, -_offset, _inSamplerate);
             resamp.init(NULL, _inSamplerate, _outSamplerate);
-            generateTaps();
+            generateTaps(_bandwidth, _outSamplerate);
             filter.init(NULL, ftaps);
 
+            // Only used for processing
+            xlator.out.free();
+            resamp.out.free();
+            filter.out.free();
+
             base_type::init(in);
         }
 
         void setInSamplerate(double inSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _inSamplerate = inSamplerate;
-            xlator.setOffset(-_offset, _inSamplerate);
-            resamp.setInSamplerate(_inSamplerate);
-            base_type::tempStart();
+            commit();
         }
 
         void setOutSamplerate(double outSamplerate, double bandwidth) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _outSamplerate = outSamplerate;
-            _bandwidth = bandwidth;
-            filterNeeded = (_bandwidth != _outSamplerate);
-            resamp.setOutSamplerate(_outSamplerate);
-            if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+            {
+                std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+                _outSamplerate = outSamplerate;
+                _bandwidth = bandwidth;
+                commit();
             }
-            base_type::tempStart();
+            retuned();
         }
 
         void setBandwidth(double bandwidth) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            std::lock_guard<std::mutex> lck2(filterMtx);
-            _bandwidth = bandwidth;
-            filterNeeded = (_bandwidth != _outSamplerate);
-            if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+            {
+                std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+                _bandwidth = bandwidth;
+                commit();
             }
+            retuned();
         }
 
         void setOffset(double offset) {
+            assert(base_type::_block_init);
+            {
+                std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+                _offset = offset;
+                commit();
+            }
+            retuned();
+        }
+
+        // Use an input that is already translated to the VFO offset, like a channelizer output, or go back to translating
+        // the input. The offset set afterwards is then only passed on to the retune handler.
+        void setPretunedInput(bool pretuned, double inSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            _offset = offset;
-            xlator.setOffset(-_offset, _inSamplerate);
+            _pretuned = pretuned;
+            _inSamplerate = inSamplerate;
+            commit();
+        }
+
+        // Called after the offset, bandwidth or output samplerate changed, by the thread that changed them and without any lock held
+        void setRetuneHandler(void (*handler)(RxVFO* vfo, void* ctx), void* ctx) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            retuneHandler = handler;
+            retuneCtx = ctx;
+        }
+
+        inline double getOffset() { return _offset; }
+        inline double getBandwidth() { return _bandwidth; }
+        inline double getOutSamplerate() { return _outSamplerate; }
+        inline bool isPretuned() { return _pretuned; }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            Settings& next = pending.front();
+
+            // Only redo the work that depends on what actually changed
+            if (next.inSamplerate != current.inSamplerate || next.outSamplerate != current.outSamplerate) {
+                resamp.setRates(next.inSamplerate, next.outSamplerate);
+            }
+            if (next.inSamplerate != current.inSamplerate || next.offset != current.offset || next.pretuned != current.pretuned) {
+                xlator.setOffset(next.pretuned ? 0.0 : -next.offset, next.inSamplerate);
+            }
+            if (next.bandwidth != current.bandwidth || next.outSamplerate != current.outSamplerate) {
+                filterNeeded = (next.bandwidth != next.outSamplerate);
+                if (filterNeeded) {
+                    generateTaps(next.bandwidth, next.outSamplerate);
+                    filter.setTaps(ftaps);
+                }
+            }
+
+            current = next;
+            return true;
         }
 
         void reset() {
@@ -87,22 +134,28 @@ namespace dsp::channel {
         }
 
         inline int process(int count, const complex_t* in, complex_t* out) {
-            xlator.process(count, in, out);
-            if (!filterNeeded) {
-                return resamp.process(count, out, out);
+            // A pretuned input goes straight to the resampler
+            if (current.pretuned) {
+                count = resamp.process(count, in, out);
             }
-            count = resamp.process(count, out, out);
-            {
-                std::lock_guard<std::mutex> lck(filterMtx);
-                filter.process(count, out, out);
+            else {
+                xlator.process(count, in, out);
+                count = resamp.process(count, out, out);
             }
+            if (filterNeeded) { filter.process(count, out, out); }
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            // The translated input is resampled in place
+            return std::max<int>(inputSize, resamp.getOutputSize(inputSize));
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             int outCount = process(count, base_type::_in->readBuf, out.writeBuf);
 
             // Swap if some data was generated
@@ -114,10 +167,30 @@ namespace dsp::channel {
         }
 
     protected:
-        void generateTaps() {
+        struct Settings {
+            double inSamplerate;
+            double outSamplerate;
+            double bandwidth;
+            double offset;
+            bool pretuned;
+        };
+
+        // Hand the settings to the DSP thread, or apply them right away if the VFO isn't running.
+        // The inner blocks are never running, so anything update() does to them happens immediately.
+        void commit() {
+            pending.back() = { _inSamplerate, _outSamplerate, _bandwidth, _offset, _pretuned };
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        void retuned() {
+            if (retuneHandler) { retuneHandler(this, retuneCtx); }
+        }
+
+        void generateTaps(double bandwidth, double samplerate) {
             taps::free(ftaps);
-            double filterWidth = _bandwidth / 2.0;
-            ftaps = taps::lowPass(filterWidth, filterWidth * 0.1, _outSamplerate);
+            double filterWidth = bandwidth / 2.0;
+            ftaps = taps::lowPass(filterWidth, filterWidth * 0.1, samplerate);
         }
 
         FrequencyXlator xlator;
@@ -125,12 +198,16 @@ namespace dsp::channel {
         filter::FIR<complex_t, float> filter;
         tap<float> ftaps;
         bool filterNeeded;
+        Settings current;
+        buffer::TripleBuffer<Settings> pending;
 
         double _inSamplerate;
         double _outSamplerate;
         double _bandwidth;
         double _offset;
+        bool _pretuned = false;
 
-        std::mutex filterMtx;
+        void (*retuneHandler)(RxVFO* vfo, void* ctx) = NULL;
+        void* retuneCtx = NULL;
     };
 }
\ No newline at end of file
@@ -3,18 +3,20 @@
 #include "pcm_type.h"
 
 namespace dsp::compression {
-    class SampleStreamCompressor : public Processor<complex_t, uint8_t> {
-        using base_type = Processor<complex_t, uint8_t>;
+    // Takes either complex_t or complex16_t samples, the wire format is the same for both
+    template <class T = complex_t>
+    class SampleStreamCompressor : public Processor<T, uint8_t> {
+        using base_type = Processor<T, uint8_t>;
     public:
         SampleStreamCompressor() {}
 
-        SampleStreamCompressor(stream<complex_t>* in, PCMType pcmType) { init(in, pcmType); }
+        SampleStreamCompressor(stream<T>* in, PCMType pcmType) { init(in, pcmType); }
 
-        void init(stream<complex_t>* in, PCMType pcmType) {
+        void init(stream<T>* in, PCMType pcmType) {
             _pcmType = pcmType;
 
             // Set the output buffer size to the max size of a complex buffer + 8 bytes for the header
-            out.setBufferSize(STREAM_BUFFER_SIZE*sizeof(complex_t) + 8);
+            base_type::out.setBufferSize(STREAM_BUFFER_SIZE*sizeof(complex_t) + 8);
 
             base_type::init(in);
         }
@@ -63,6 +65,46 @@ namespace dsp::compression {
             return count;
         }
 
+        inline static int process(int count, PCMType pcmType, const complex16_t* in, uint8_t* out) {
+            uint16_t* compressionType = (uint16_t*)out;
+            uint16_t* sampleType = (uint16_t*)&out[2];
+            float* scaler = (float*)&out[4];
+            void* dataBuf = &out[8];
+
+            // Write options and leave blank space for compression
+            *compressionType = 0;
+            *sampleType = pcmType;
+
+            // Samples are already int16, send them as is with a unity scaler
+            if (pcmType == PCMType::PCM_TYPE_I16) {
+                *scaler = 1.0f;
+                memcpy(dataBuf, in, count * sizeof(complex16_t));
+                return 8 + (count * sizeof(complex16_t));
+            }
+            else if (pcmType == PCMType::PCM_TYPE_F32) {
+                *scaler = 0;
+                volk_16i_s32f_convert_32f((float*)dataBuf, (const int16_t*)in, 32768.0f, count * 2);
+                return 8 + (count * sizeof(complex_t));
+            }
+
+            // Find maximum value, like with floats the sign bit is left free
+            const int16_t* samps = (const int16_t*)in;
+            int maxVal = 1;
+            for (int i = 0; i < count * 2; i++) { maxVal = std::max<int>(maxVal, samps[i]); }
+            *scaler = (float)maxVal / 32768.0f;
+
+            // Scale to the int8 range
+            if (pcmType == PCMType::PCM_TYPE_I8) {
+                int8_t* data = (int8_t*)dataBuf;
+                for (int i = 0; i < count * 2; i++) {
+                    data[i] = std::clamp<int>((samps[i] * 128) / maxVal, -128, 127);
+                }
+                return 8 + (count * sizeof(int8_t) * 2);
+            }
+
+            return count;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
@@ -0,0 +1,31 @@
+#pragma once
+#include "../processor.h"
+
+namespace dsp::convert {
+    class Complex16ToComplex : public Processor<complex16_t, complex_t> {
+        using base_type = Processor<complex16_t, complex_t>;
+    public:
+        Complex16ToComplex() {}
+
+        Complex16ToComplex(stream<complex16_t>* in) { init(in); }
+
+        void init(stream<complex16_t>* in) { base_type::init(in); }
+
+        inline static int process(int count, const complex16_t* in, complex_t* out) {
+            volk_16i_s32f_convert_32f((float*)out, (const int16_t*)in, 32768.0f, count * 2);
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            base_type::prepareOutput(count);
+            process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            base_type::_in->flush();
+            if (!base_type::out.swap(count)) { return -1; }
+            return count;
+        }
+    };
+}
@@ -59,10 +59,22 @@ namespace dsp::correction {
             return count;
         }
 
+        bool canFuse() { return true; }
+
+        int processFused(int count, const T* in, T* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, (T*)in, out);
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -5,6 +5,7 @@
 #include "../convert/mono_to_stereo.h"
 #include "../filter/fir.h"
 #include "../taps/low_pass.h"
+#include "../buffer/triple_buffer.h"
 
 namespace dsp::demod {
     template <class T>
@@ -24,6 +25,9 @@ namespace dsp::demod {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             taps::free(lpfTaps);
+            for (int i = 0; i < pendingTaps.SLOT_COUNT; i++) {
+                taps::free(pendingTaps[i]);
+            }
         }
 
         void init(stream<complex_t>* in, AGCMode agcMode, double bandwidth, double agcAttack, double agcDecay, double dcBlockRate, double samplerate) {
@@ -60,10 +64,19 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             if (bandwidth == _bandwidth) { return; }
             _bandwidth = bandwidth;
-            std::lock_guard<std::mutex> lck2(lpfMtx);
-            taps::free(lpfTaps);
-            lpfTaps = taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
-            lpf.setTaps(lpfTaps);
+
+            // The taps are generated here and handed to the filter by the DSP thread
+            tap<float>& next = pendingTaps.back();
+            taps::free(next);
+            next = taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
+            pendingTaps.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        bool update() {
+            if (!pendingTaps.update()) { return false; }
+            lpf.setTaps(pendingTaps.front());
+            return true;
         }
 
         void setAGCAttack(double attack) {
@@ -80,6 +93,13 @@ namespace dsp::demod {
             audioAgc.setDecay(decay);
         }
 
+        void setAGCLookAhead(int samples) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            carrierAgc.setLookAhead(samples);
+            audioAgc.setLookAhead(samples);
+        }
+
         void setDCBlockRate(double rate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -111,10 +131,7 @@ namespace dsp::demod {
                 if (_agcMode == AGCMode::AUDIO) {
                     audioAgc.process(count, out, out);
                 }
-                {
-                    std::lock_guard<std::mutex> lck(lpfMtx);
-                    lpf.process(count, out, out);
-                }
+                lpf.process(count, out, out);
             }
             if constexpr (std::is_same_v<T, stereo_t>) {
                 volk_32fc_magnitude_32f(audioAgc.out.writeBuf, (lv_32fc_t*)in, count);
@@ -122,20 +139,22 @@ namespace dsp::demod {
                 if (_agcMode == AGCMode::AUDIO) {
                     audioAgc.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
                 }
-                {
-                    std::lock_guard<std::mutex> lck(lpfMtx);
-                    lpf.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
-                }
+                lpf.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
                 convert::MonoToStereo::process(count, audioAgc.out.writeBuf, out);
             }
 
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -153,8 +172,8 @@ namespace dsp::demod {
         loop::AGC<float> audioAgc;
         correction::DCBlocker<float> dcBlock;
         tap<float> lpfTaps;
+        buffer::TripleBuffer<tap<float>> pendingTaps;
         filter::FIR<float, float> lpf;
-        std::mutex lpfMtx;
 
     };
 }
\ No newline at end of file
@@ -214,11 +214,16 @@ namespace dsp::demod {
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
             int rdsOutCount = 0;
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf, rdsOutCount, rdsOut.writeBuf);
 
             base_type::_in->flush();
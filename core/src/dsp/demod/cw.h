@@ -47,6 +47,12 @@ namespace dsp::demod {
             agc.setDecay(decay);
         }
 
+        void setAGCLookAhead(int samples) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            agc.setLookAhead(samples);
+        }
+
         void setSamplerate(double samplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -6,6 +6,7 @@
 #include "../taps/high_pass.h"
 #include "../taps/band_pass.h"
 #include "../convert/mono_to_stereo.h"
+#include "../buffer/triple_buffer.h"
 
 namespace dsp::demod {
     template <class T>
@@ -33,7 +34,8 @@ namespace dsp::demod {
             fir.init(NULL, filterTaps);
 
             // Initialize taps
-            updateFilter(lowPass, highPass);
+            current = { _samplerate, _bandwidth, _lowPass, _highPass };
+            updateFilter(current);
 
             if constexpr (std::is_same_v<T, float>) {
                 demod.out.free();
@@ -46,11 +48,8 @@ namespace dsp::demod {
         void setSamplerate(double samplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _samplerate = samplerate;
-            demod.setDeviation(_bandwidth / 2.0, _samplerate);
-            updateFilter(_lowPass, _highPass);
-            base_type::tempStart();
+            commit();
         }
 
         void setBandwidth(double bandwidth) {
@@ -58,20 +57,32 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             if (bandwidth == _bandwidth) { return; }
             _bandwidth = bandwidth;
-            demod.setDeviation(_bandwidth / 2.0, _samplerate);
-            updateFilter(_lowPass, _highPass);
+            commit();
         }
 
         void setLowPass(bool lowPass) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            updateFilter(lowPass, _highPass);
+            _lowPass = lowPass;
+            commit();
         }
 
         void setHighPass(bool highPass) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            updateFilter(_lowPass, highPass);
+            _highPass = highPass;
+            commit();
+        }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            Settings& next = pending.front();
+            if (next.samplerate != current.samplerate || next.bandwidth != current.bandwidth) {
+                demod.setDeviation(next.bandwidth / 2.0, next.samplerate);
+            }
+            updateFilter(next);
+            current = next;
+            return true;
         }
 
         void reset() {
@@ -87,14 +98,12 @@ namespace dsp::demod {
             if constexpr (std::is_same_v<T, float>) {
                 demod.process(count, in, out);
                 if (filtering) {
-                    std::lock_guard<std::mutex> lck(filterMtx);
                     fir.process(count, out, out);
                 }
             }
             if constexpr (std::is_same_v<T, stereo_t>) {
                 demod.process(count, in, demod.out.writeBuf);
                 if (filtering) {
-                    std::lock_guard<std::mutex> lck(filterMtx);
                     fir.process(count, demod.out.writeBuf, demod.out.writeBuf);
                 }
                 convert::MonoToStereo::process(count, demod.out.writeBuf, out);
@@ -102,10 +111,15 @@ namespace dsp::demod {
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -114,26 +128,35 @@ namespace dsp::demod {
         }
 
     private:
-        void updateFilter(bool lowPass, bool highPass) {
-            std::lock_guard<std::mutex> lck(filterMtx);
+        struct Settings {
+            double samplerate;
+            double bandwidth;
+            bool lowPass;
+            bool highPass;
+        };
+
+        // Hand the settings to the DSP thread, or apply them right away if the demodulator isn't running
+        void commit() {
+            pending.back() = { _samplerate, _bandwidth, _lowPass, _highPass };
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
 
-            // Update values
-            _lowPass = lowPass;
-            _highPass = highPass;
-            filtering = (lowPass || highPass);
+        void updateFilter(const Settings& settings) {
+            filtering = (settings.lowPass || settings.highPass);
 
             // Free filter taps
             dsp::taps::free(filterTaps);
 
             // Generate filter depending on low and high pass settings
-            if (_lowPass && _highPass) {
-                filterTaps = dsp::taps::bandPass<float>(300.0, _bandwidth / 2.0, 100.0, _samplerate);
+            if (settings.lowPass && settings.highPass) {
+                filterTaps = dsp::taps::bandPass<float>(300.0, settings.bandwidth / 2.0, 100.0, settings.samplerate);
             }
-            else if (_highPass) {
-                filterTaps = dsp::taps::highPass(300.0, 100.0, _samplerate);
+            else if (settings.highPass) {
+                filterTaps = dsp::taps::highPass(300.0, 100.0, settings.samplerate);
             }
-            else if (_lowPass) {
-                filterTaps = dsp::taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
+            else if (settings.lowPass) {
+                filterTaps = dsp::taps::lowPass(settings.bandwidth / 2.0, (settings.bandwidth / 2.0) * 0.1, settings.samplerate);
             }
             else {
                 loadDummyTaps();
@@ -154,10 +177,11 @@ namespace dsp::demod {
         bool _lowPass;
         bool _highPass;
         bool filtering;
+        Settings current;
+        buffer::TripleBuffer<Settings> pending;
 
         Quadrature demod;
         tap<float> filterTaps;
         filter::FIR<float, float> fir;
-        std::mutex filterMtx;
     };
 }
\ No newline at end of file
@@ -1,13 +1,23 @@
 #pragma once
 #include "../processor.h"
-#include "../math/fast_atan2.h"
+#include "../kernels/kernels.h"
+#include "../buffer/triple_buffer.h"
 #include "../math/hz_to_rads.h"
 #include "../math/normalize_phase.h"
 
+// Number of samples demodulated at once, the phase differences are kept on the stack
+#define QUADRATURE_CHUNK_SIZE   1024
+
 namespace dsp::demod {
     class Quadrature : public Processor<complex_t, float> {
         using base_type = Processor<complex_t, float>;
     public:
+        enum Accuracy {
+            EXACT,      // atan2f from the C library
+            HIGH,       // Vectorized polynomial, within 1e-6 rad
+            FAST        // Vectorized polynomial, within 2e-5 rad
+        };
+
         Quadrature() {}
 
         Quadrature(stream<complex_t>* in, double deviation) { init(in, deviation); }
@@ -36,11 +46,42 @@ namespace dsp::demod {
             _invDeviation = 1.0 / math::hzToRads(deviation, samplerate);
         }
 
+        // Handed to the DSP thread like the settings of the other demodulators, it takes effect on the next block of samples
+        void setAccuracy(Accuracy accuracy) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            pending.back() = accuracy;
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            _accuracy = pending.front();
+            return true;
+        }
+
         inline int process(int count, complex_t* in, float* out) {
-            for (int i = 0; i < count; i++) {
-                float cphase = in[i].phase();
-                out[i] = math::normalizePhase(cphase - phase) * _invDeviation;
-                phase = cphase;
+            alignas(32) complex_t diff[QUADRATURE_CHUNK_SIZE];
+            for (int i = 0; i < count; i += QUADRATURE_CHUNK_SIZE) {
+                int n = std::min<int>(count - i, QUADRATURE_CHUNK_SIZE);
+
+                // The phase difference with the previous sample is the phase of the product with its conjugate
+                diff[0] = in[i] * last.conj();
+                volk_32fc_x2_multiply_conjugate_32fc((lv_32fc_t*)&diff[1], (lv_32fc_t*)&in[i + 1], (lv_32fc_t*)&in[i], n - 1);
+                last = in[i + n - 1];
+
+                switch(_accuracy) {
+                    case Accuracy::EXACT:
+                        for (int j = 0; j < n; j++) { out[i + j] = diff[j].phase() * _invDeviation; }
+                        break;
+                    case Accuracy::HIGH:
+                        kernels::get().phase(&out[i], diff, _invDeviation, n);
+                        break;
+                    case Accuracy::FAST:
+                        kernels::get().fastPhase(&out[i], diff, _invDeviation, n);
+                        break;
+                }
             }
             return count;
         }
@@ -48,13 +89,18 @@ namespace dsp::demod {
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            phase = 0.0f;
+            last = { 1.0f, 0.0f };
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
         }
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -64,6 +110,8 @@ namespace dsp::demod {
 
     protected:
         float _invDeviation;
-        float phase = 0.0f;
+        Accuracy _accuracy = HIGH;
+        buffer::TripleBuffer<Accuracy> pending;
+        complex_t last = { 1.0f, 0.0f };
     };
 }
\ No newline at end of file
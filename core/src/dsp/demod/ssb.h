@@ -4,6 +4,7 @@
 #include "../convert/complex_to_real.h"
 #include "../loop/agc.h"
 #include "../convert/mono_to_stereo.h"
+#include "../buffer/triple_buffer.h"
 
 namespace dsp::demod {
     template <class T>
@@ -38,28 +39,28 @@ namespace dsp::demod {
         void setMode(Mode mode) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _mode = mode;
-            xlator.setOffset(getTranslation(), _samplerate);
-            base_type::tempStart();
+            commit();
         }
 
         void setBandwidth(double bandwidth) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _bandwidth = bandwidth;
-            xlator.setOffset(getTranslation(), _samplerate);
-            base_type::tempStart();
+            commit();
         }
 
         void setSamplerate(double samplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _samplerate = samplerate;
-            xlator.setOffset(getTranslation(), _samplerate);
-            base_type::tempStart();
+            commit();
+        }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            xlator.setOffset(pending.front().translation, pending.front().samplerate);
+            return true;
         }
 
         void setAGCAttack(double attack) {
@@ -74,6 +75,12 @@ namespace dsp::demod {
             agc.setDecay(decay);
         }
 
+        void setAGCLookAhead(int samples) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            agc.setLookAhead(samples);
+        }
+
         int process(int count, const complex_t* in, T* out) {
             // Move back sideband
             xlator.process(count, in, xlator.out.writeBuf);
@@ -91,10 +98,15 @@ namespace dsp::demod {
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -103,6 +115,18 @@ namespace dsp::demod {
         }
 
     protected:
+        struct Settings {
+            double translation;
+            double samplerate;
+        };
+
+        // Hand the sideband translation to the DSP thread, or apply it right away if the demodulator isn't running
+        void commit() {
+            pending.back() = { getTranslation(), _samplerate };
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
         double getTranslation() {
             if (_mode == Mode::USB) {
                 return _bandwidth / 2.0;
@@ -120,6 +144,7 @@ namespace dsp::demod {
         double _samplerate;
         channel::FrequencyXlator xlator;
         loop::AGC<float> agc;
+        buffer::TripleBuffer<Settings> pending;
 
     };
 };
\ No newline at end of file
@@ -0,0 +1,366 @@
+#include "plan.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <utils/flog.h>
+#include "../threading.h"
+
+namespace dsp::fft {
+    namespace {
+        // FFTW's planner isn't thread safe, creating or destroying plans and loading or saving the wisdom all hold this.
+        // A measurement holds it for up to FFT_PLAN_TIME_LIMIT, so only the planner thread and acquire() ever wait for it,
+        // everything else only tries to take it. When both are needed, it's taken before entryMtx.
+        std::mutex plannerMtx;
+
+        // Plans in use by size and direction, the planner thread state and its queues. Only held for bookkeeping, never
+        // while planning.
+        std::mutex entryMtx;
+        std::map<std::pair<int, int>, PlanEntry*> entries;
+        std::deque<PlanEntry*> makeQueue;
+        std::deque<PlanEntry*> measureQueue;
+        std::vector<PlanEntry*> unused;
+        int waiting = 0;
+        std::condition_variable workCnd;
+        std::condition_variable exitCnd;
+        bool running = false;
+        bool threadRunning = false;
+        Effort _effort = EFFORT_ESTIMATE;
+        std::string _wisdomPath;
+
+        unsigned int getFlags(Effort effort) {
+            switch (effort) {
+                case EFFORT_MEASURE:
+                    return FFTW_MEASURE;
+                case EFFORT_PATIENT:
+                    return FFTW_PATIENT;
+                default:
+                    return FFTW_ESTIMATE;
+            }
+        }
+
+        // Must be called with plannerMtx held
+        fftwf_plan createPlan(int size, int direction, unsigned int flags) {
+            // Measuring overwrites the buffers, so they're only used for planning. They give the plan the alignment of fftwf_malloc().
+            fftwf_complex* in = fftwf_alloc_complex(size);
+            fftwf_complex* out = fftwf_alloc_complex(size);
+            fftwf_plan plan = fftwf_plan_dft_1d(size, in, out, direction, flags);
+            fftwf_free(in);
+            fftwf_free(out);
+            return plan;
+        }
+
+        // Must be called with entryMtx held. Entries are shared by size and direction, a new one has no plan yet.
+        PlanEntry* ref(int size, int direction) {
+            auto it = entries.find({ size, direction });
+            if (it != entries.end()) {
+                it->second->refCount++;
+                return it->second;
+            }
+            PlanEntry* entry = new PlanEntry;
+            entry->size = size;
+            entry->direction = direction;
+            entry->refCount = 1;
+            entries[{ size, direction }] = entry;
+            return entry;
+        }
+
+        // Must be called with entryMtx held. Entries nobody uses anymore are destroyed the next time the planner is free.
+        void unref(PlanEntry* entry) {
+            if (--entry->refCount) { return; }
+            entries.erase({ entry->size, entry->direction });
+            unused.push_back(entry);
+            if (running) { workCnd.notify_one(); }
+        }
+
+        // Must be called with plannerMtx held and entryMtx not held, the caller must hold a reference to the entry.
+        // Gives the entry the measured plan if the wisdom has it, otherwise an estimate that gets queued for measuring.
+        void makePlan(PlanEntry* entry) {
+            unsigned int flags;
+            {
+                std::lock_guard<std::mutex> lck(entryMtx);
+                if (entry->current.load()) { return; }
+                flags = getFlags(_effort);
+            }
+
+            fftwf_plan measured = NULL;
+            fftwf_plan estimate = NULL;
+            if (flags != FFTW_ESTIMATE) {
+                measured = createPlan(entry->size, entry->direction, flags | FFTW_WISDOM_ONLY);
+            }
+            if (!measured) {
+                estimate = createPlan(entry->size, entry->direction, FFTW_ESTIMATE);
+            }
+
+            // The planner thread holds its own reference until it's done measuring
+            std::lock_guard<std::mutex> lck(entryMtx);
+            entry->measured = measured;
+            entry->estimate = estimate;
+            entry->current.store(measured ? measured : estimate, std::memory_order_release);
+            if (!measured && running) {
+                entry->refCount++;
+                measureQueue.push_back(entry);
+                workCnd.notify_one();
+            }
+        }
+
+        // Must be called with plannerMtx held and entryMtx not held
+        void destroyUnused() {
+            std::vector<PlanEntry*> dead;
+            {
+                std::lock_guard<std::mutex> lck(entryMtx);
+                dead.swap(unused);
+            }
+            for (auto& entry : dead) {
+                if (entry->estimate) { fftwf_destroy_plan(entry->estimate); }
+                if (entry->measured) { fftwf_destroy_plan(entry->measured); }
+                delete entry;
+            }
+        }
+
+        // Without the planner thread, whoever lets go of an entry destroys it, unless the planner is in use. In that case
+        // the next one to get it does.
+        void destroyUnusedIfFree() {
+            if (!plannerMtx.try_lock()) { return; }
+            destroyUnused();
+            plannerMtx.unlock();
+        }
+
+        // Must be called with plannerMtx held and entryMtx not held
+        void saveWisdom(const std::string& path) {
+            if (path.empty()) { return; }
+            if (!fftwf_export_wisdom_to_filename(path.c_str())) {
+                flog::warn("Could not save the FFTW wisdom to {0}", path);
+            }
+        }
+
+        void plannerLoop() {
+            threading::setupCurrentThread("FFT Planner");
+
+            std::unique_lock<std::mutex> lck(entryMtx);
+            while (true) {
+                // No measurement is started while acquire() waits for the planner, so it waits for one at most
+                workCnd.wait(lck, []() { return !running || !makeQueue.empty() || !unused.empty() || (!measureQueue.empty() && !waiting); });
+                if (!running) { break; }
+
+                // Plans waited for and unused entries are dealt with first, so they never wait for more than the
+                // measurement in progress
+                if (!makeQueue.empty() || !unused.empty()) {
+                    std::deque<PlanEntry*> toMake;
+                    toMake.swap(makeQueue);
+                    lck.unlock();
+                    {
+                        std::lock_guard<std::mutex> plck(plannerMtx);
+                        for (auto& entry : toMake) {
+                            makePlan(entry);
+                        }
+                        destroyUnused();
+                    }
+                    lck.lock();
+                    for (auto& entry : toMake) {
+                        entry->queued = false;
+                        unref(entry);
+                    }
+                    continue;
+                }
+
+                PlanEntry* entry = measureQueue.front();
+                measureQueue.pop_front();
+
+                // Skip plans released while they were waiting
+                if (entry->refCount == 1) {
+                    unref(entry);
+                    continue;
+                }
+
+                // Measure without holding entryMtx so that other plans can still be acquired and released. Users of
+                // this entry keep executing the estimate in the meantime.
+                int size = entry->size;
+                int direction = entry->direction;
+                unsigned int flags = getFlags(_effort);
+                lck.unlock();
+                auto planStart = std::chrono::steady_clock::now();
+                fftwf_plan plan;
+                {
+                    std::lock_guard<std::mutex> plck(plannerMtx);
+                    plan = createPlan(size, direction, flags);
+                }
+                auto planEnd = std::chrono::steady_clock::now();
+                lck.lock();
+
+                // The estimate is kept until the entry is destroyed since other threads may still be executing it
+                if (plan) {
+                    entry->measured = plan;
+                    entry->current.store(plan, std::memory_order_release);
+                    flog::info("Measured the plan of a {0} point FFT in {1}ms", size, (int)std::chrono::duration_cast<std::chrono::milliseconds>(planEnd - planStart).count());
+                }
+                unref(entry);
+
+                // Save once everything queued is measured, there's no point in writing it after every plan
+                if (measureQueue.empty()) {
+                    std::string path = _wisdomPath;
+                    lck.unlock();
+                    {
+                        std::lock_guard<std::mutex> plck(plannerMtx);
+                        saveWisdom(path);
+                    }
+                    lck.lock();
+                }
+            }
+
+            threadRunning = false;
+            exitCnd.notify_all();
+        }
+    }
+
+    // Must be called with entryMtx held. The new entry is taken before letting go of the old one so that keeping the
+    // same size keeps the same plan.
+    void Plan::setEntry(int size, int direction) {
+        PlanEntry* next = ref(size, direction);
+        if (entry) { unref(entry); }
+        entry = next;
+    }
+
+    void Plan::acquire(int size, int direction) {
+        std::unique_lock<std::mutex> lck(entryMtx);
+        setEntry(size, direction);
+        if (entry->current.load(std::memory_order_acquire)) {
+            lck.unlock();
+            destroyUnusedIfFree();
+            return;
+        }
+        waiting++;
+        lck.unlock();
+
+        // The estimate is made right away, once the measurement in progress if any is done
+        {
+            std::lock_guard<std::mutex> plck(plannerMtx);
+            makePlan(entry);
+            destroyUnused();
+        }
+
+        lck.lock();
+        if (!--waiting && running) { workCnd.notify_one(); }
+    }
+
+    bool Plan::tryAcquire(int size, int direction) {
+        if (entry && entry->size == size && entry->direction == direction && entry->current.load(std::memory_order_acquire)) {
+            return true;
+        }
+
+        bool threaded;
+        {
+            std::lock_guard<std::mutex> lck(entryMtx);
+            if (!entry || entry->size != size || entry->direction != direction) { setEntry(size, direction); }
+            if (entry->current.load(std::memory_order_acquire)) { return true; }
+            threaded = running;
+
+            // The planner thread holds its own reference until the plan is made
+            if (threaded && !entry->queued) {
+                entry->queued = true;
+                entry->refCount++;
+                makeQueue.push_back(entry);
+                workCnd.notify_one();
+            }
+        }
+        if (threaded || !plannerMtx.try_lock()) { return false; }
+
+        // Without the planner thread, the plan is made right away if nobody else is planning
+        makePlan(entry);
+        destroyUnused();
+        plannerMtx.unlock();
+        return true;
+    }
+
+    void Plan::release() {
+        if (!entry) { return; }
+        bool threaded;
+        {
+            std::lock_guard<std::mutex> lck(entryMtx);
+            unref(entry);
+            entry = NULL;
+            threaded = running;
+        }
+        if (!threaded) { destroyUnusedIfFree(); }
+    }
+
+    void Plan::swap(Plan& b) {
+        std::swap(entry, b.entry);
+    }
+
+    bool Plan::isMeasured() {
+        if (!entry) { return false; }
+        std::lock_guard<std::mutex> lck(entryMtx);
+        return entry->measured;
+    }
+
+    void init(const std::string& wisdomPath, Effort effort) {
+        std::lock_guard<std::mutex> plck(plannerMtx);
+        std::lock_guard<std::mutex> lck(entryMtx);
+        if (running) { return; }
+        _wisdomPath = wisdomPath;
+        _effort = effort;
+
+        if (fftwf_import_wisdom_from_filename(_wisdomPath.c_str())) {
+            flog::info("Loaded the FFTW wisdom from {0}", _wisdomPath);
+        }
+        fftwf_set_timelimit(FFT_PLAN_TIME_LIMIT);
+
+        if (effort == EFFORT_ESTIMATE) { return; }
+
+        // Detached so that exiting without calling end() doesn't abort, end() waits for it instead
+        running = true;
+        threadRunning = true;
+        std::thread(plannerLoop).detach();
+    }
+
+    void end() {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lck(entryMtx);
+            if (!running) { return; }
+
+            // Stop the planner thread, a measurement in progress has to finish first
+            running = false;
+            workCnd.notify_all();
+            exitCnd.wait(lck, []() { return !threadRunning; });
+
+            // Drop the plans that were never made or measured. Those never made are made by the next tryAcquire(), the
+            // others stay estimates.
+            for (auto& entry : makeQueue) {
+                entry->queued = false;
+                unref(entry);
+            }
+            makeQueue.clear();
+            for (auto& entry : measureQueue) {
+                unref(entry);
+            }
+            measureQueue.clear();
+            _effort = EFFORT_ESTIMATE;
+            path = _wisdomPath;
+        }
+
+        std::lock_guard<std::mutex> plck(plannerMtx);
+        destroyUnused();
+        saveWisdom(path);
+    }
+
+    bool parseEffort(const std::string& str, Effort& effort) {
+        if (str == "estimate") {
+            effort = EFFORT_ESTIMATE;
+        }
+        else if (str == "measure") {
+            effort = EFFORT_MEASURE;
+        }
+        else if (str == "patient") {
+            effort = EFFORT_PATIENT;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+}
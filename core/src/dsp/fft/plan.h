@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <fftw3.h>
+#include "../types.h"
+
+// Measuring a plan stops after this many seconds and keeps the fastest one found so far. Making an estimate may have to
+// wait for the measurement in progress, so this bounds that wait. FFTW can't resume a measurement that timed out.
+#define FFT_PLAN_TIME_LIMIT     0.5
+
+namespace dsp::fft {
+    enum Effort {
+        EFFORT_ESTIMATE,
+        EFFORT_MEASURE,
+        EFFORT_PATIENT
+    };
+
+    // Plan shared by every user of the same size and direction. It starts without a plan, gets the measured plan if the
+    // wisdom already has it or an estimate otherwise, and the measured plan replaces the estimate once the planner thread
+    // has made it.
+    struct PlanEntry {
+        int size;
+        int direction;
+        std::atomic<fftwf_plan> current = NULL;
+        fftwf_plan estimate = NULL;
+        fftwf_plan measured = NULL;
+        int refCount = 0;
+        bool queued = false;
+    };
+
+    // Handle to an out of place complex FFT plan. Buffers given to execute() must come from fftwf_malloc() so that they
+    // have the alignment the plan was made for. Several threads may execute the same plan at once on their own buffers.
+    class Plan {
+    public:
+        Plan() {}
+
+        Plan(int size, int direction) { acquire(size, direction); }
+
+        ~Plan() { release(); }
+
+        Plan(const Plan&) = delete;
+        Plan& operator=(const Plan&) = delete;
+
+        // Get the plan for the given size and direction (FFTW_FORWARD or FFTW_BACKWARD), releasing the previous one.
+        // The plan is always ready on return. If it has to be made, the estimate is made right away, after waiting for
+        // the measurement the planner thread may be doing (at most FFT_PLAN_TIME_LIMIT), and the planner doesn't start
+        // another one until it's made.
+        void acquire(int size, int direction);
+
+        // Same as acquire() but never waits for the planner, for users that have something else to fall back to.
+        // Returns false if the plan isn't made yet, it's then made in the background and a later call with the same size
+        // and direction returns true once it's ready. Once ready, calling it again with the same size and direction only
+        // checks that nothing changed.
+        bool tryAcquire(int size, int direction);
+
+        void release();
+
+        // Exchange the plans of two handles
+        void swap(Plan& b);
+
+        inline bool isReady() {
+            return entry && entry->current.load(std::memory_order_acquire);
+        }
+
+        // The plan must be ready
+        inline void execute(const complex_t* in, complex_t* out) {
+            fftwf_execute_dft(entry->current.load(std::memory_order_acquire), (fftwf_complex*)in, (fftwf_complex*)out);
+        }
+
+        bool isMeasured();
+
+        int getSize() {
+            return entry ? entry->size : 0;
+        }
+
+    private:
+        void setEntry(int size, int direction);
+
+        PlanEntry* entry = NULL;
+    };
+
+    // Load the wisdom and start measuring plans in the background with the given effort.
+    // Until this is called, or with EFFORT_ESTIMATE, all plans stay estimates.
+    void init(const std::string& wisdomPath, Effort effort = EFFORT_MEASURE);
+
+    // Stop the planner thread and save the wisdom
+    void end();
+
+    // Parse an effort name ("estimate", "measure" or "patient"), returns false if unknown
+    bool parseEffort(const std::string& str, Effort& effort);
+}
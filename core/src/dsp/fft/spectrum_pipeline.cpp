@@ -0,0 +1,239 @@
+#include "spectrum_pipeline.h"
+#include <algorithm>
+#include <math.h>
+#include <string>
+#include <string.h>
+#include <volk/volk.h>
+#include "../buffer/buffer.h"
+#include "../threading.h"
+
+namespace dsp::fft {
+    SpectrumPipeline::~SpectrumPipeline() {
+        if (!_init) { return; }
+        stopWorkers();
+        buffer::free(_window);
+        buffer::free(powerSum);
+    }
+
+    void SpectrumPipeline::init(int threads, float* (*acquireBuffer)(void* ctx), void (*releaseBuffer)(void* ctx), void* ctx) {
+        _acquireBuffer = acquireBuffer;
+        _releaseBuffer = releaseBuffer;
+        _ctx = ctx;
+        startWorkers(threads);
+        _init = true;
+    }
+
+    void SpectrumPipeline::setParams(int fftSize, const float* window, int windowSize, int averages) {
+        flush();
+
+        // The workers are all idle, so their buffers can be swapped
+        _fftSize = fftSize;
+        _windowSize = std::min<int>(windowSize, fftSize);
+        buffer::free(_window);
+        _window = buffer::alloc<float>(_windowSize);
+        memcpy(_window, window, _windowSize * sizeof(float));
+        _averages = std::max<int>(averages, 1);
+        averaged = 0;
+        buffer::free(powerSum);
+        powerSum = buffer::alloc<float>(_fftSize);
+        for (auto& w : workers) {
+            freeBuffers(w);
+            allocBuffers(w);
+        }
+
+        plan.acquire(_fftSize, FFTW_FORWARD);
+    }
+
+    void SpectrumPipeline::setThreads(int threads) {
+        stopWorkers();
+        startWorkers(threads);
+    }
+
+    int SpectrumPipeline::getThreads() {
+        return workers.size();
+    }
+
+    void SpectrumPipeline::push(const complex_t* data, int count) {
+        if (!_fftSize) { return; }
+        Worker* w = workers[pushed % workers.size()];
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            cnd.wait(lck, [=]() { return !w->busy; });
+        }
+
+        // Only this thread touches the buffers of an idle worker
+        volk_32fc_32f_multiply_32fc((lv_32fc_t*)w->in, (lv_32fc_t*)data, _window, std::min<int>(count, _windowSize));
+
+        std::lock_guard<std::mutex> lck(mtx);
+        w->view = _view;
+        if (w->view.pixels > (int)w->reduced.size()) { w->reduced.resize(w->view.pixels); }
+        w->frame = pushed++;
+        w->busy = true;
+        cnd.notify_all();
+    }
+
+    void SpectrumPipeline::flush() {
+        std::unique_lock<std::mutex> lck(mtx);
+        cnd.wait(lck, [=]() { return delivered == pushed; });
+    }
+
+    void SpectrumPipeline::setView(const SpectrumView& view) {
+        std::lock_guard<std::mutex> lck(mtx);
+        _view = view;
+        _view.pixels = std::clamp<int>(_view.pixels, 0, SPECTRUM_PIPELINE_MAX_PIXELS);
+    }
+
+    const SpectrumView& SpectrumPipeline::getDeliveredView() {
+        return deliveredView;
+    }
+
+    void SpectrumPipeline::workerLoop(Worker* w, int id) {
+        threading::setupCurrentThread("FFT Worker " + std::to_string(id));
+
+        std::unique_lock<std::mutex> lck(mtx);
+        while (true) {
+            cnd.wait(lck, [=]() { return w->busy || !running; });
+            if (!running) { break; }
+            lck.unlock();
+
+            // Transform and convert to dB, or to power when averaging, while the other workers do the same with the frames around it
+            plan.execute(w->in, w->out);
+            if (_averages > 1) {
+                volk_32fc_magnitude_squared_32f(w->spectrum, (lv_32fc_t*)w->out, _fftSize);
+            }
+            else {
+                volk_32fc_s32f_power_spectrum_32f(w->spectrum, (lv_32fc_t*)w->out, _fftSize, _fftSize);
+                if (w->view.pixels) { reduce(w->spectrum, w->view, w->reduced.data()); }
+            }
+
+            // Hand over in frame order
+            lck.lock();
+            cnd.wait(lck, [=]() { return delivered == w->frame; });
+            lck.unlock();
+            if (_averages > 1) {
+                accumulate(w->spectrum, w->view, w->reduced.data());
+            }
+            else {
+                deliver(w->view.pixels ? w->reduced.data() : w->spectrum, w->view);
+            }
+
+            lck.lock();
+            delivered++;
+            w->busy = false;
+            cnd.notify_all();
+        }
+    }
+
+    void SpectrumPipeline::accumulate(const float* power, const SpectrumView& view, float* reduced) {
+        if (averaged) {
+            volk_32f_x2_add_32f(powerSum, powerSum, power, _fftSize);
+        }
+        else {
+            memcpy(powerSum, power, _fftSize * sizeof(float));
+        }
+        if (++averaged < _averages) { return; }
+        averaged = 0;
+
+        // Same scale as volk_32fc_s32f_power_spectrum_32f, 10*log10(power / (averages * size^2)) done as a scaled log2
+        volk_32f_s32f_multiply_32f(powerSum, powerSum, 1.0f / ((float)_averages * (float)_fftSize * (float)_fftSize), _fftSize);
+        volk_32f_log2_32f(powerSum, powerSum, _fftSize);
+        volk_32f_s32f_multiply_32f(powerSum, powerSum, 10.0f * log10f(2.0f), _fftSize);
+
+        if (view.pixels) {
+            reduce(powerSum, view, reduced);
+            deliver(reduced, view);
+        }
+        else {
+            deliver(powerSum, view);
+        }
+    }
+
+    void SpectrumPipeline::deliver(const float* spectrum, const SpectrumView& view) {
+        deliveredView = view;
+        float* buf = _acquireBuffer(_ctx);
+        if (buf) { memcpy(buf, spectrum, (view.pixels ? view.pixels : _fftSize) * sizeof(float)); }
+        _releaseBuffer(_ctx);
+    }
+
+    void SpectrumPipeline::reduce(const float* spectrum, const SpectrumView& view, float* out) {
+        // Each pixel takes the bins from its left edge up to the next one's, at least one so that zooming past the
+        // resolution of the FFT repeats bins. Pixels off the spectrum are left empty.
+        double binsPerPixel = view.width * (double)_fftSize / (double)view.pixels;
+        double first = view.start * (double)_fftSize;
+        const float dbToLog2 = log2f(10.0f) / 10.0f;
+        for (int i = 0; i < view.pixels; i++) {
+            int lo = floor(first + (double)i * binsPerPixel);
+            int hi = std::max<int>(lo + 1, floor(first + (double)(i + 1) * binsPerPixel));
+            lo = std::clamp<int>(lo, 0, _fftSize);
+            hi = std::clamp<int>(hi, 0, _fftSize);
+            if (lo >= hi) {
+                out[i] = -INFINITY;
+                continue;
+            }
+
+            if (view.mode == REDUCE_MEAN) {
+                // Averaging the dB values would give the geometric mean instead, which is 2.5dB under the mean power of noise
+                float sum = 0.0f;
+                for (int j = lo; j < hi; j++) { sum += exp2f(spectrum[j] * dbToLog2); }
+                out[i] = 10.0f * log10f(sum / (float)(hi - lo));
+            }
+            else {
+                float max = spectrum[lo];
+                for (int j = lo + 1; j < hi; j++) { max = std::max<float>(max, spectrum[j]); }
+                out[i] = max;
+            }
+        }
+    }
+
+    void SpectrumPipeline::startWorkers(int threads) {
+        if (threads <= 0) { threads = std::clamp<int>(std::thread::hardware_concurrency() / 2, 1, 4); }
+        threads = std::min<int>(threads, SPECTRUM_PIPELINE_MAX_THREADS);
+
+        running = true;
+        for (int i = 0; i < threads; i++) {
+            Worker* w = new Worker;
+            allocBuffers(w);
+            workers.push_back(w);
+        }
+
+        // Frames are handed to the workers in turn, starting over from the first one
+        pushed = 0;
+        delivered = 0;
+        for (int i = 0; i < threads; i++) {
+            workers[i]->thread = std::thread(&SpectrumPipeline::workerLoop, this, workers[i], i);
+        }
+    }
+
+    void SpectrumPipeline::stopWorkers() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            running = false;
+            cnd.notify_all();
+        }
+        for (auto& w : workers) {
+            if (w->thread.joinable()) { w->thread.join(); }
+            freeBuffers(w);
+            delete w;
+        }
+        workers.clear();
+    }
+
+    void SpectrumPipeline::allocBuffers(Worker* w) {
+        if (!_fftSize) { return; }
+        w->in = (complex_t*)fftwf_malloc(_fftSize * sizeof(complex_t));
+        w->out = (complex_t*)fftwf_malloc(_fftSize * sizeof(complex_t));
+        w->spectrum = buffer::alloc<float>(_fftSize);
+
+        // Only the start of the input is overwritten by frames, the rest stays zero
+        buffer::clear(w->in, _fftSize);
+    }
+
+    void SpectrumPipeline::freeBuffers(Worker* w) {
+        if (!w->in) { return; }
+        fftwf_free(w->in);
+        fftwf_free(w->out);
+        buffer::free(w->spectrum);
+        w->in = NULL;
+    }
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "plan.h"
+
+// Most worker threads a spectrum pipeline can use
+#define SPECTRUM_PIPELINE_MAX_THREADS   8
+
+// Widest reduced spectrum, in pixels
+#define SPECTRUM_PIPELINE_MAX_PIXELS    8192
+
+namespace dsp::fft {
+    enum ReduceMode {
+        REDUCE_MAX,     // Strongest bin of each pixel
+        REDUCE_MEAN     // Mean power of the bins of each pixel
+    };
+
+    // Part of the spectrum reduced to one value per pixel, with start and width as fractions of the whole spectrum.
+    // Zero pixels hands over the whole spectrum instead.
+    struct SpectrumView {
+        int pixels = 0;
+        double start = 0.0;
+        double width = 1.0;
+        ReduceMode mode = REDUCE_MAX;
+
+        bool operator==(const SpectrumView& b) const {
+            return pixels == b.pixels && start == b.start && width == b.width && mode == b.mode;
+        }
+
+        bool operator!=(const SpectrumView& b) const {
+            return !(*this == b);
+        }
+    };
+
+    // Windows frames, transforms them and converts them to a dB power spectrum. Consecutive frames go to different worker
+    // threads so that the windowing, FFT and dB conversion of several frames overlap, and large FFTs keep up with the
+    // frame rate. Spectra are still handed over in the order the frames came in. With averaging, the power of
+    // consecutive frames is averaged before the conversion to dB (Welch's method) and one spectrum is handed over per group.
+    // With a view set, only the part of the spectrum on screen is handed over, reduced to the width of the display.
+    class SpectrumPipeline {
+    public:
+        SpectrumPipeline() {}
+
+        ~SpectrumPipeline();
+
+        // Zero threads means one for every two cores, up to four
+        void init(int threads, float* (*acquireBuffer)(void* ctx), void (*releaseBuffer)(void* ctx), void* ctx);
+
+        // Set the FFT size, the window, which has one value per sample of a frame, and the number of frames averaged
+        // into each spectrum. Frames shorter than the FFT are zero padded. Must not be called while frames are pushed.
+        void setParams(int fftSize, const float* window, int windowSize, int averages = 1);
+
+        // Must not be called while frames are pushed
+        void setThreads(int threads);
+        int getThreads();
+
+        // Window a frame into the next worker and let it run, waiting if it's still busy with its previous frame
+        void push(const complex_t* data, int count);
+
+        // Wait until every frame pushed so far is handed over
+        void flush();
+
+        // Reduce the spectra of the frames pushed from now on, the pixel count is limited to SPECTRUM_PIPELINE_MAX_PIXELS
+        void setView(const SpectrumView& view);
+
+        // View of the spectrum being handed over, only valid from the acquire callback to the release callback
+        const SpectrumView& getDeliveredView();
+
+    private:
+        struct Worker {
+            std::thread thread;
+            complex_t* in = NULL;
+            complex_t* out = NULL;
+            float* spectrum = NULL;
+            std::vector<float> reduced;
+            SpectrumView view;
+            int64_t frame = 0;
+            bool busy = false;
+        };
+
+        void workerLoop(Worker* w, int id);
+        void accumulate(const float* power, const SpectrumView& view, float* reduced);
+        void deliver(const float* spectrum, const SpectrumView& view);
+        void reduce(const float* spectrum, const SpectrumView& view, float* out);
+        void startWorkers(int threads);
+        void stopWorkers();
+        void allocBuffers(Worker* w);
+        void freeBuffers(Worker* w);
+
+        float* (*_acquireBuffer)(void* ctx);
+        void (*_releaseBuffer)(void* ctx);
+        void* _ctx;
+
+        int _fftSize = 0;
+        int _windowSize = 0;
+        float* _window = NULL;
+        Plan plan;
+
+        // Power summed over the frames of the current group, only touched by the worker whose turn it is
+        int _averages = 1;
+        int averaged = 0;
+        float* powerSum = NULL;
+
+        SpectrumView _view;
+        SpectrumView deliveredView;
+
+        std::vector<Worker*> workers;
+        std::mutex mtx;
+        std::condition_variable cnd;
+        bool running = false;
+
+        // Frame numbers of the next frame to be pushed and of the next one to be handed over
+        int64_t pushed = 0;
+        int64_t delivered = 0;
+
+        bool _init = false;
+    };
+}
@@ -15,13 +15,10 @@ namespace dsp::filter {
             base_type::init(in, taps);
         }
 
-        void setTaps(tap<T>& taps) {
-            assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
+        bool update() {
+            if (!base_type::update()) { return false; }
             offset = 0;
-            base_type::setTaps(taps);
-            base_type::tempStart();
+            return true;
         }
 
         void setDecimation(int decimation) {
@@ -30,6 +27,7 @@ namespace dsp::filter {
             base_type::tempStop();
             _decimation = decimation;
             offset = 0;
+            base_type::selectMethod();
             base_type::tempStart();
         }
 
@@ -43,34 +41,57 @@ namespace dsp::filter {
         }
 
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(base_type::bufStart, in, count * sizeof(D));
+            base_type::delay.begin(in, count);
+
+            // When filtering in place, outputs that would overwrite input samples still needed are held back until the end
+            int hist = base_type::_taps.size - 1;
+            D* spill = NULL;
+            if (buffer::overlaps(in, count * sizeof(D), out, getOutputSize(count) * sizeof(D))) {
+                spill = base_type::delay.spill(getOutputSize(count));
+            }
 
             // Do convolution
             int outCount = 0;
-            for (; offset < count; offset += _decimation) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], base_type::_taps.taps, base_type::_taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
-                    volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&base_type::buffer[offset], (lv_32fc_t*)base_type::_taps.taps, base_type::_taps.size);
+            base_type::fitFFT(count);
+            if (base_type::fftSize) {
+                outCount = base_type::processFFT(count, out, offset, _decimation, spill);
+            }
+            else {
+                int spilled = 0;
+                for (; offset < count; offset += _decimation) {
+                    D* dst = &out[outCount];
+                    if (spill && outCount >= offset - hist) {
+                        dst = &spill[outCount];
+                        spilled = outCount + 1;
+                    }
+                    if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
+                        volk_32f_x2_dot_prod_32f(dst, base_type::delay.window(offset), base_type::_taps.taps, base_type::_taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
+                        volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)dst, (lv_32fc_t*)base_type::delay.window(offset), base_type::_taps.taps, base_type::_taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
+                        volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)dst, (lv_32fc_t*)base_type::delay.window(offset), (lv_32fc_t*)base_type::_taps.taps, base_type::_taps.size);
+                    }
+                    outCount++;
                 }
+                if (spilled) { memcpy(out, spill, spilled * sizeof(D)); }
             }
             offset -= count;
 
-            // Move unused data
-            memmove(base_type::buffer, &base_type::buffer[count], (base_type::_taps.size - 1) * sizeof(D));
-
+            base_type::delay.end();
             return outCount;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize / _decimation + 1;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             // Swap if some data was generated
@@ -82,6 +103,11 @@ namespace dsp::filter {
         }
 
     protected:
+        // Only every decimation-th output is computed by the direct form
+        int getDirectCost() {
+            return base_type::_taps.size / _decimation;
+        }
+
         int _decimation;
         int offset = 0;
     };
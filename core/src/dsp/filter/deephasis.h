@@ -76,11 +76,23 @@ namespace dsp::filter {
             return count;
         }
 
+        bool canFuse() { return true; }
+
+        int processFused(int count, const T* in, T* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         //DEFAULT_PROC_RUN();
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
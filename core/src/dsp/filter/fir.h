@@ -1,6 +1,15 @@
 #pragma once
 #include "../processor.h"
+#include "../fft/plan.h"
 #include "../taps/tap.h"
+#include "../buffer/triple_buffer.h"
+#include "../buffer/delay_line.h"
+
+// Filters doing at least this many multiply-accumulates per input sample (the tap count for a plain FIR) use FFT overlap-save
+// convolution instead of one dot product per output sample. The crossover depends on the CPU and on VOLK's dot products,
+// the FIR and DecimatingFIR method cases of sdrpp_bench measure both methods over a range of tap counts. This is a
+// conservative value keeping short filters, like most decimation stages and resampler filters, on the direct form.
+#define FIR_FFT_THRESHOLD   64
 
 namespace dsp::filter {
     template <class D, class T>
@@ -14,16 +23,21 @@ namespace dsp::filter {
         ~FIR() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
+            taps::free(_taps);
+            for (int i = 0; i < pendingTaps.SLOT_COUNT; i++) {
+                taps::free(pendingTaps[i]);
+            }
+            destroyFFT();
         }
 
         virtual void init(stream<D>* in, tap<T>& taps) {
-            _taps = taps;
+            // The filter works on its own copy of the taps
+            _taps = copyTaps(taps);
+
+            // The delay line holds the last samples of the previous block
+            delay.init(_taps.size - 1);
 
-            // Allocate and clear buffer
-            buffer = buffer::alloc<D>(STREAM_BUFFER_SIZE + 64000);
-            bufStart = &buffer[_taps.size - 1];
-            buffer::clear<D>(buffer, _taps.size - 1);
+            selectMethod();
 
             base_type::init(in);
         }
@@ -31,61 +45,86 @@ namespace dsp::filter {
         virtual void setTaps(tap<T>& taps) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
 
-            int oldTC = _taps.size;
-            _taps = taps;
+            // The copy is prepared here and swapped in by the DSP thread, the taps it replaces come back in the slot
+            tap<T>& next = pendingTaps.back();
+            taps::free(next);
+            next = copyTaps(taps);
+            pendingTaps.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        bool update() {
+            if (!pendingTaps.update()) { return false; }
 
-            // Update start of buffer
-            bufStart = &buffer[_taps.size - 1];
+            std::swap(_taps, pendingTaps.front());
 
-            // Move existing data to make transition seemless
-            if (_taps.size < oldTC) {
-                memmove(buffer, &buffer[oldTC - _taps.size], (_taps.size - 1) * sizeof(D));
-            }
-            else if (_taps.size > oldTC) {
-                memmove(&buffer[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(D));
-                buffer::clear<D>(buffer, _taps.size - oldTC);
-            }
-            
+            // Keep the newest samples to make transition seemless
+            delay.setLength(_taps.size - 1);
+
+            selectMethod();
+            return true;
+        }
+
+        // Set the number of multiply-accumulates per input sample above which FFT convolution is used,
+        // zero always uses it and INT_MAX never does
+        void setFFTThreshold(int threshold) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            fftThreshold = threshold;
+            selectMethod();
             base_type::tempStart();
         }
 
+        bool isUsingFFT() {
+            return fftSize > 0;
+        }
+
         virtual void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            buffer::clear<D>(buffer, _taps.size - 1);
+            delay.clear();
             base_type::tempStart();
         }
 
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(D));
-            
-            // Do convolution
-            for (int i = 0; i < count; i++) {
-                if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[i], &buffer[i], _taps.taps, _taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], _taps.taps, _taps.size);
-                }
-                if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
-                    volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)&buffer[i], (lv_32fc_t*)_taps.taps, _taps.size);
+            delay.begin(in, count);
+
+            // Do convolution. Outputs are computed from last to first so that the input can be overwritten with the output.
+            fitFFT(count);
+            if (fftSize) {
+                int pos = 0;
+                processFFT(count, out, pos, 1, NULL);
+            }
+            else {
+                for (int i = count - 1; i >= 0; i--) {
+                    if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
+                        volk_32f_x2_dot_prod_32f(&out[i], delay.window(i), _taps.taps, _taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, float>) {
+                        volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)delay.window(i), _taps.taps, _taps.size);
+                    }
+                    if constexpr ((std::is_same_v<D, complex_t> || std::is_same_v<D, stereo_t>) && std::is_same_v<T, complex_t>) {
+                        volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)delay.window(i), (lv_32fc_t*)_taps.taps, _taps.size);
+                    }
                 }
             }
 
-            // Move unused data
-            memmove(buffer, &buffer[count], (_taps.size - 1) * sizeof(D));
-
+            delay.end();
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
@@ -94,8 +133,230 @@ namespace dsp::filter {
         }
 
     protected:
+        // Multiply-accumulates per input sample done by the direct form
+        virtual int getDirectCost() {
+            return _taps.size;
+        }
+
+        // Compute the outputs at positions pos, pos + step, ... up to count with overlap-save, the block must already be in the
+        // delay line. The output is the same as the direct form's, up to rounding. Without decimation, segments are filtered
+        // from last to first so that the output can overwrite the input. With decimation, they are filtered in order and the
+        // outputs that would overwrite input still needed go to spill (NULL if the output can't overlap the input).
+        int processFFT(int count, D* out, int& pos, int step, D* spill) {
+            int hist = _taps.size - 1;
+
+            // Real samples go through the FFT two segments at a time
+            int span = std::is_same_v<D, float> ? 2 * fftHop : fftHop;
+            int spans = (count + span - 1) / span;
+
+            if (step == 1) {
+                for (int j = spans - 1; j >= 0; j--) {
+                    int s = j * span;
+                    int n = std::min<int>(span, count - s);
+                    filterSpan(s, count);
+                    if constexpr (std::is_same_v<D, float>) {
+                        for (int i = s; i < s + n; i++) { out[i] = spanResult(s, i); }
+                    }
+                    else {
+                        memcpy(&out[s], &fftIn[hist], n * sizeof(D));
+                    }
+                }
+                pos = count;
+                return count;
+            }
+
+            int outCount = 0;
+            int spilled = 0;
+            for (int s = 0; s < count; s += span) {
+                int n = std::min<int>(span, count - s);
+                if (pos >= s + n) { continue; }
+                filterSpan(s, count);
+                for (; pos < s + n; pos += step) {
+                    D val = spanResult(s, pos);
+                    if (spill && outCount >= pos - hist) {
+                        spill[outCount] = val;
+                        spilled = outCount + 1;
+                    }
+                    else {
+                        out[outCount] = val;
+                    }
+                    outCount++;
+                }
+            }
+            if (spilled) { memcpy(out, spill, spilled * sizeof(D)); }
+
+            return outCount;
+        }
+
+        // Filter the span of positions starting at s, the result is read with spanResult()
+        void filterSpan(int s, int count) {
+            int hist = _taps.size - 1;
+            if constexpr (std::is_same_v<D, float>) {
+                // The two segments are gathered in the output buffer before being interleaved, it gets overwritten by the FFT anyway
+                int n0 = std::min<int>(fftHop, count - s);
+                int n1 = std::clamp<int>(count - s - fftHop, 0, fftHop);
+                int len0 = n0 + hist;
+                int len1 = n1 ? (n1 + hist) : 0;
+                float* seg0 = (float*)fftOut;
+                float* seg1 = &seg0[fftSize];
+                delay.read(seg0, s, len0);
+                if (len1) { delay.read(seg1, s + fftHop, len1); }
+                for (int i = 0; i < fftSize; i++) {
+                    fftIn[i].re = (i < len0) ? seg0[i] : 0.0f;
+                    fftIn[i].im = (i < len1) ? seg1[i] : 0.0f;
+                }
+            }
+            else {
+                // Stereo samples are handled as complex ones, each channel only mixes with itself through real taps
+                int len = std::min<int>(fftHop, count - s) + hist;
+                delay.read((D*)fftIn, s, len);
+                buffer::clear(&fftIn[len], fftSize - len);
+            }
+            convolveFFT();
+        }
+
+        // Output at position pos of the span starting at s
+        inline D spanResult(int s, int pos) {
+            int hist = _taps.size - 1;
+            if constexpr (std::is_same_v<D, float>) {
+                return (pos < s + fftHop) ? fftIn[hist + pos - s].re : fftIn[hist + pos - s - fftHop].im;
+            }
+            else {
+                return *(D*)&fftIn[hist + pos - s];
+            }
+        }
+
+        // Circular convolution of fftIn with the taps, the result replaces the input
+        inline void convolveFFT() {
+            forwPlan.execute(fftIn, fftOut);
+            volk_32fc_x2_multiply_32fc((lv_32fc_t*)fftOut, (lv_32fc_t*)fftOut, (lv_32fc_t*)fftTaps, fftSize);
+            backPlan.execute(fftOut, fftIn);
+        }
+
+        // Switch between direct and FFT convolution for the current taps, called by the DSP thread when the taps change
+        void selectMethod() {
+            useFFT = (getDirectCost() >= fftThreshold);
+            if (!useFFT) {
+                destroyFFT();
+                nextForwPlan.release();
+                nextBackPlan.release();
+                return;
+            }
+
+            // Until blocks come in, assume they're three times the tap count, which gives an FFT of about four times the tap count
+            resizeFFT(fftBlockSize ? fftBlockSize : 3 * _taps.size, true);
+        }
+
+        // Grow or shrink the FFT when blocks no longer match the size it was picked for, or try again to switch to it
+        inline void fitFFT(int count) {
+            if (!useFFT) { return; }
+            if (!fftSize || count > fftBlockSize || count < fftBlockSize / 2) { resizeFFT(count, false); }
+        }
+
+        // Use the FFT size doing the least work for blocks of the given size, the taps are transformed again if it changed or if forced.
+        // The plans are made in the background, until they are the current FFT is kept if it still fits the taps and the
+        // direct form is used otherwise. The block size is only recorded once the switch is done, so the next blocks try again.
+        void resizeFFT(int count, bool force) {
+            // Real samples go through the FFT two segments at a time
+            int segments = std::is_same_v<D, float> ? 2 : 1;
+            double bestCost = INFINITY;
+            int bestSize = 0;
+            for (int size = 64; bestSize == 0 || size <= 4 * bestSize; size <<= 1) {
+                // The overlap would make up most of the FFT below twice the tap count
+                if (size < 2 * _taps.size) { continue; }
+                int hop = segments * (size - _taps.size + 1);
+                double cost = (double)((count + hop - 1) / hop) * (double)size * log2((double)size);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestSize = size;
+                }
+
+                // Larger sizes would only compute more outputs than the block needs
+                if (hop >= count) { break; }
+            }
+
+            if (bestSize != fftSize) {
+                bool forwReady = nextForwPlan.tryAcquire(bestSize, FFTW_FORWARD);
+                bool backReady = nextBackPlan.tryAcquire(bestSize, FFTW_BACKWARD);
+                if (!forwReady || !backReady) {
+                    if (fftSize < _taps.size) { destroyFFT(); }
+                    if (!fftSize || !force) { return; }
+                }
+                else {
+                    destroyFFT();
+                    createFFT(bestSize);
+                }
+            }
+            else if (!force) {
+                fftBlockSize = count;
+                return;
+            }
+            if (fftSize == bestSize) { fftBlockSize = count; }
+            fftHop = fftSize - _taps.size + 1;
+
+            // The direct form correlates with the taps, so the FFT uses them reversed. The scale undoes the unnormalized inverse FFT.
+            for (int i = 0; i < _taps.size; i++) {
+                if constexpr (std::is_same_v<T, float>) {
+                    fftIn[i] = { _taps.taps[_taps.size - 1 - i], 0.0f };
+                }
+                else {
+                    fftIn[i] = _taps.taps[_taps.size - 1 - i];
+                }
+            }
+            buffer::clear(&fftIn[_taps.size], fftSize - _taps.size);
+            forwPlan.execute(fftIn, fftOut);
+            float scale = 1.0f / (float)fftSize;
+            for (int i = 0; i < fftSize; i++) {
+                fftTaps[i] = fftOut[i] * scale;
+            }
+        }
+
+        // The plans of the given size must be ready in nextForwPlan and nextBackPlan
+        void createFFT(int size) {
+            fftSize = size;
+            fftIn = (complex_t*)fftwf_malloc(fftSize * sizeof(complex_t));
+            fftOut = (complex_t*)fftwf_malloc(fftSize * sizeof(complex_t));
+            fftTaps = (complex_t*)fftwf_malloc(fftSize * sizeof(complex_t));
+            forwPlan.swap(nextForwPlan);
+            backPlan.swap(nextBackPlan);
+            nextForwPlan.release();
+            nextBackPlan.release();
+        }
+
+        void destroyFFT() {
+            if (!fftSize) { return; }
+            forwPlan.release();
+            backPlan.release();
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            fftwf_free(fftTaps);
+            fftSize = 0;
+        }
+
+        static tap<T> copyTaps(const tap<T>& taps) {
+            tap<T> copy = taps::alloc<T>(taps.size);
+            memcpy(copy.taps, taps.taps, taps.size * sizeof(T));
+            return copy;
+        }
+
         tap<T> _taps;
-        D* buffer;
-        D* bufStart;
+        buffer::TripleBuffer<tap<T>> pendingTaps;
+        buffer::DelayLine<D> delay;
+
+        // FFT convolution, only allocated when in use
+        int fftThreshold = FIR_FFT_THRESHOLD;
+        bool useFFT = false;
+        int fftSize = 0;
+        int fftHop;
+        int fftBlockSize = 0;
+        complex_t* fftIn;
+        complex_t* fftOut;
+        complex_t* fftTaps;
+        fft::Plan forwPlan;
+        fft::Plan backPlan;
+
+        // Plans of the size being switched to, held while they're being made
+        fft::Plan nextForwPlan;
+        fft::Plan nextBackPlan;
     };
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include <vector>
+#include "processor.h"
+
+// Default number of input samples pushed through all fused blocks at once
+#define FUSED_DEFAULT_CHUNK_SIZE 16384
+
+namespace dsp {
+    // Runs a sequence of processors from a single thread, ping-ponging between two work buffers
+    template <class T>
+    class FusedProcessor : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        FusedProcessor() {}
+
+        FusedProcessor(stream<T>* in, const std::vector<Processor<T, T>*>& blocks, int chunkSize = FUSED_DEFAULT_CHUNK_SIZE) { init(in, blocks, chunkSize); }
+
+        ~FusedProcessor() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            if (work[0]) { buffer::free(work[0]); }
+            if (work[1]) { buffer::free(work[1]); }
+        }
+
+        void init(stream<T>* in, const std::vector<Processor<T, T>*>& blocks, int chunkSize = FUSED_DEFAULT_CHUNK_SIZE) {
+            _blocks = blocks;
+            _chunkSize = chunkSize;
+
+            // Work buffers are grown to what the blocks ask for once data comes in
+            for (int i = 0; i < 2; i++) {
+                work[i] = NULL;
+                workSize[i] = 0;
+            }
+
+            base_type::init(in);
+        }
+
+        void setBlocks(const std::vector<Processor<T, T>*>& blocks) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _blocks = blocks;
+            base_type::tempStart();
+        }
+
+        void setChunkSize(int chunkSize) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _chunkSize = chunkSize;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            int outCount = 0;
+            int last = _blocks.size() - 1;
+            int chunk = (_chunkSize > 0) ? _chunkSize : count;
+
+            for (int offset = 0; offset < count; offset += chunk) {
+                // Run the chunk through every block, the last one writes directly to the output
+                int n = std::min<int>(chunk, count - offset);
+                const T* data = &in[offset];
+                for (int i = 0; i <= last && n > 0; i++) {
+                    T* dst = (i == last) ? &out[outCount] : reserveWork(i & 1, _blocks[i]->getOutputSize(n));
+                    n = _blocks[i]->processFused(n, data, dst);
+                    data = dst;
+                }
+                if (n > 0) { outCount += n; }
+            }
+
+            return outCount;
+        }
+
+        int getOutputSize(int inputSize) {
+            if (_blocks.empty() || inputSize <= 0) { return inputSize; }
+
+            // Each chunk may produce as much as the last block allows for it
+            int chunk = (_chunkSize > 0) ? std::min<int>(_chunkSize, inputSize) : inputSize;
+            int chunks = (inputSize + chunk - 1) / chunk;
+            for (auto& blk : _blocks) {
+                chunk = blk->getOutputSize(chunk);
+            }
+            return (int)std::min<int64_t>((int64_t)chunks * chunk, STREAM_BUFFER_SIZE);
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            // Fused blocks can be reconfigured without stopping this one, so their settings are applied and their output size checked on every run
+            for (auto& blk : _blocks) { blk->update(); }
+            base_type::out.reserve(getOutputSize(count));
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // The other work buffer holds the input of the current block, so only this one may be reallocated
+        inline T* reserveWork(int id, int size) {
+            size = std::min<int>(size, STREAM_BUFFER_SIZE);
+            if (size > workSize[id]) {
+                if (work[id]) { buffer::free(work[id]); }
+                work[id] = buffer::alloc<T>(size);
+                workSize[id] = size;
+            }
+            return work[id];
+        }
+
+        std::vector<Processor<T, T>*> _blocks;
+        int _chunkSize;
+        T* work[2];
+        int workSize[2];
+    };
+}
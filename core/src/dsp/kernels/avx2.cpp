@@ -0,0 +1,9 @@
+// AVX2 and FMA variants of the kernels, see impl.h
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNEL_TARGET __attribute__((target("avx2,fma")))
+#include "impl.h"
+
+namespace dsp::kernels {
+    extern const Table avx2Table = Impl<LEVEL_AVX2>::table;
+}
+#endif
@@ -0,0 +1,9 @@
+// AVX-512F variants of the kernels, see impl.h
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNEL_TARGET __attribute__((target("avx512f")))
+#include "impl.h"
+
+namespace dsp::kernels {
+    extern const Table avx512Table = Impl<LEVEL_AVX512>::table;
+}
+#endif
@@ -0,0 +1,97 @@
+#pragma once
+#include <math.h>
+#include <algorithm>
+#include "kernels.h"
+#include "../math/fast_atan2.h"
+
+// Each level is built by its own translation unit, which defines KERNEL_TARGET to the function attributes enabling its
+// instruction set before including this file. Only the functions below get those attributes, so the inline functions
+// shared with the rest of the code never end up built for an instruction set the CPU may not have.
+#ifndef KERNEL_TARGET
+#define KERNEL_TARGET
+#endif
+
+// Levels other than the generic one are only built where they can be selected with function attributes
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// Number of independent sums kept by reductions, float additions can't be reordered into vectors otherwise
+#define KERNEL_LANES    16
+
+// Number of palette indices computed before looking them up
+#define KERNEL_CHUNK    256
+
+namespace dsp::kernels {
+    template <Level L>
+    struct Impl {
+        template <int TERMS>
+        static KERNEL_TARGET void phase(float* out, const complex_t* in, float scale, int count) {
+            for (int i = 0; i < count; i++) {
+                out[i] = math::polyAtan2<TERMS>(in[i].re, in[i].im) * scale;
+            }
+        }
+
+        // Compilers don't vectorize sqrtf unless allowed to ignore errno, so the x86 levels use intrinsics
+        static KERNEL_TARGET inline void sqrtLanes(float* vals) {
+#ifdef KERNELS_X86
+            if constexpr (L == LEVEL_AVX512) {
+                _mm512_storeu_ps(vals, _mm512_sqrt_ps(_mm512_loadu_ps(vals)));
+                return;
+            }
+            else if constexpr (L == LEVEL_AVX2) {
+                for (int l = 0; l < KERNEL_LANES; l += 8) { _mm256_storeu_ps(&vals[l], _mm256_sqrt_ps(_mm256_loadu_ps(&vals[l]))); }
+                return;
+            }
+            else if constexpr (L == LEVEL_SSE4) {
+                for (int l = 0; l < KERNEL_LANES; l += 4) { _mm_storeu_ps(&vals[l], _mm_sqrt_ps(_mm_loadu_ps(&vals[l]))); }
+                return;
+            }
+#endif
+            for (int l = 0; l < KERNEL_LANES; l++) { vals[l] = sqrtf(vals[l]); }
+        }
+
+        static KERNEL_TARGET float amplitudeSum(const complex_t* in, int count) {
+            float acc[KERNEL_LANES] = {};
+            float amps[KERNEL_LANES];
+            int i = 0;
+            for (; i + KERNEL_LANES <= count; i += KERNEL_LANES) {
+                for (int l = 0; l < KERNEL_LANES; l++) {
+                    amps[l] = in[i + l].re * in[i + l].re + in[i + l].im * in[i + l].im;
+                }
+                sqrtLanes(amps);
+                for (int l = 0; l < KERNEL_LANES; l++) { acc[l] += amps[l]; }
+            }
+            for (int l = 0; i < count; i++, l++) {
+                acc[l] += sqrtf(in[i].re * in[i].re + in[i].im * in[i].im);
+            }
+            float sum = 0.0f;
+            for (int l = 0; l < KERNEL_LANES; l++) { sum += acc[l]; }
+            return sum;
+        }
+
+        static KERNEL_TARGET void paletteMap(uint32_t* out, const float* in, int count, float min, float max, const uint32_t* palette, int paletteSize) {
+            float scale = (max > min) ? (float)(paletteSize - 1) / (max - min) : 0.0f;
+            int ids[KERNEL_CHUNK];
+            for (int i = 0; i < count; i += KERNEL_CHUNK) {
+                // Indices are computed separately since compilers won't vectorize the loop with the lookup in it.
+                // The comparisons are written so that NaNs end up at the minimum and each is a single instruction.
+                int n = std::min<int>(KERNEL_CHUNK, count - i);
+                for (int j = 0; j < n; j++) {
+                    float val = (in[i + j] > min) ? in[i + j] : min;
+                    val = (val < max) ? val : max;
+                    ids[j] = (int)((val - min) * scale);
+                }
+                for (int j = 0; j < n; j++) { out[i + j] = palette[ids[j]]; }
+            }
+        }
+
+        static constexpr Table table = {
+            phase<5>,
+            phase<9>,
+            amplitudeSum,
+            paletteMap
+        };
+    };
+}
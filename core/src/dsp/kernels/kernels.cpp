@@ -0,0 +1,96 @@
+#include "impl.h"
+#include <algorithm>
+#include <string>
+#include <utils/flog.h>
+
+namespace dsp::kernels {
+#ifdef KERNELS_X86
+    extern const Table sse4Table;
+    extern const Table avx2Table;
+    extern const Table avx512Table;
+#endif
+
+    Table active = Impl<LEVEL_GENERIC>::table;
+
+    bool isSupported(Level level) {
+#ifdef KERNELS_X86
+        __builtin_cpu_init();
+        switch (level) {
+            case LEVEL_GENERIC:
+                return true;
+            case LEVEL_SSE4:
+                return __builtin_cpu_supports("sse4.1");
+            case LEVEL_AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case LEVEL_AVX512:
+                return __builtin_cpu_supports("avx512f");
+            default:
+                return false;
+        }
+#else
+        return level == LEVEL_GENERIC;
+#endif
+    }
+
+    const char* getLevelName(Level level) {
+        switch (level) {
+            case LEVEL_GENERIC:
+                return "generic";
+            case LEVEL_SSE4:
+                return "sse4";
+            case LEVEL_AVX2:
+                return "avx2";
+            case LEVEL_AVX512:
+                return "avx512";
+            default:
+                return "unknown";
+        }
+    }
+
+    const Table* getLevel(Level level) {
+        if (!isSupported(level)) { return NULL; }
+        switch (level) {
+            case LEVEL_GENERIC:
+                return &Impl<LEVEL_GENERIC>::table;
+#ifdef KERNELS_X86
+            case LEVEL_SSE4:
+                return &sse4Table;
+            case LEVEL_AVX2:
+                return &avx2Table;
+            case LEVEL_AVX512:
+                return &avx512Table;
+#endif
+            default:
+                return NULL;
+        }
+    }
+
+    // Use the highest level that has the kernel and add it to the description
+    template <class F>
+    void select(F Table::* kernel, const char* name, Level maxLevel, std::string& desc) {
+        for (int l = maxLevel; l >= LEVEL_GENERIC; l--) {
+            const Table* table = getLevel((Level)l);
+            if (!table || !(table->*kernel)) { continue; }
+            active.*kernel = table->*kernel;
+            desc += std::string(desc.empty() ? "" : ", ") + name + "=" + getLevelName((Level)l);
+            return;
+        }
+    }
+
+    void init(Level maxLevel) {
+        std::string desc;
+        select(&Table::fastPhase, "fastPhase", maxLevel, desc);
+        select(&Table::phase, "phase", maxLevel, desc);
+        select(&Table::amplitudeSum, "amplitudeSum", maxLevel, desc);
+
+        // The palette lookup stays one load per value at every level, only the short index loop gets wider. Its AVX-512
+        // build measured about 20% slower than the AVX2 one in sdrpp_bench, so it stops at AVX2.
+        select(&Table::paletteMap, "paletteMap", std::min<Level>(maxLevel, LEVEL_AVX2), desc);
+
+        flog::info("DSP kernels: {0}", desc);
+    }
+
+    const Table& get() {
+        return active;
+    }
+}
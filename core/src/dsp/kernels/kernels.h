@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include "../types.h"
+
+namespace dsp::kernels {
+    // Instruction sets the kernels are built for, from the least to the most preferred
+    enum Level {
+        LEVEL_GENERIC,
+        LEVEL_SSE4,
+        LEVEL_AVX2,
+        LEVEL_AVX512,
+        _LEVEL_COUNT
+    };
+
+    // Primitives VOLK doesn't provide. Every level is built from the same code, only the instructions differ.
+    struct Table {
+        // Scaled phase of each sample, with the 5 (fastPhase) or 9 (phase) term polynomials of math::polyAtan2
+        void (*fastPhase)(float* out, const complex_t* in, float scale, int count);
+        void (*phase)(float* out, const complex_t* in, float scale, int count);
+
+        // Sum of the amplitudes of all samples
+        float (*amplitudeSum)(const complex_t* in, int count);
+
+        // Palette entry of each value, with min to max spread over the whole palette and values out of range clamped
+        void (*paletteMap)(uint32_t* out, const float* in, int count, float min, float max, const uint32_t* palette, int paletteSize);
+    };
+
+    // Select the best variant of each kernel the CPU supports, up to the given level, and log the selection.
+    // Until this is called the generic variants are used.
+    void init(Level maxLevel = LEVEL_AVX512);
+
+    // Selected variants
+    const Table& get();
+
+    // Variants of a given level, NULL when they weren't built or the CPU can't run them
+    const Table* getLevel(Level level);
+
+    bool isSupported(Level level);
+    const char* getLevelName(Level level);
+}
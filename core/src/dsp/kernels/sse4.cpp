@@ -0,0 +1,9 @@
+// SSE4.1 variants of the kernels, see impl.h
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNEL_TARGET __attribute__((target("sse4.1")))
+#include "impl.h"
+
+namespace dsp::kernels {
+    extern const Table sse4Table = Impl<LEVEL_SSE4>::table;
+}
+#endif
@@ -10,6 +10,16 @@ namespace dsp::loop {
 
         AGC(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) { init(in, setPoint, attack, decay, maxGain, maxOutputAmp, initGain); }
 
+        ~AGC() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            if (!capacity) { return; }
+            buffer::free(amps);
+            buffer::free(gains);
+            buffer::free(peaks);
+            buffer::free(segMax);
+        }
+
         void init(stream<T>* in, double setPoint, double attack, double decay, double maxGain, double maxOutputAmp, double initGain = 1.0) {
             _setPoint = setPoint;
             _attack = attack;
@@ -61,6 +71,13 @@ namespace dsp::loop {
             _initGain = initGain;
         }
 
+        // Number of samples scanned for the peak amplitude once clipping is detected, zero to scan up to the end of the block
+        void setLookAhead(int samples) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            _lookAhead = samples;
+        }
+
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -68,43 +85,62 @@ namespace dsp::loop {
         }
 
         inline int process(int count, T* in, T* out) {
+            reserve(count);
+
+            // Get the amplitude of the whole block at once
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_magnitude_32f(amps, (lv_32fc_t*)in, count);
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                for (int i = 0; i < count; i++) { amps[i] = fabsf(in[i]); }
+            }
+
+            // Peaks are only computed the first time clipping is detected, most blocks never clip
+            bool peaksReady = false;
+
+            // The state is kept in locals, the compiler would otherwise reload it after every write to the gains
+            float amp = this->amp;
+            float setPoint = _setPoint;
+            float maxGain = _maxGain;
+            float maxOutputAmp = _maxOutputAmp;
+            float attack = _attack;
+            float invAttack = _invAttack;
+            float decay = _decay;
+            float invDecay = _invDecay;
+
             for (int i = 0; i < count; i++) {
-                // Get signal amplitude
-                float inAmp, gain;
-                if constexpr (std::is_same_v<T, complex_t>) {
-                    inAmp = in[i].amplitude();
-                }
-                if constexpr (std::is_same_v<T, float>) {
-                    inAmp = fabsf(in[i]);
-                }
+                float inAmp = amps[i];
+                float gain;
 
                 // Update average amplitude
                 if (inAmp != 0.0f) {
-                    amp = (inAmp > amp) ? ((amp * _invAttack) + (inAmp * _attack)) : ((amp * _invDecay) + (inAmp * _decay));
-                    gain = std::min<float>(_setPoint / amp, _maxGain);
+                    amp = (inAmp > amp) ? ((amp * invAttack) + (inAmp * attack)) : ((amp * invDecay) + (inAmp * decay));
+                    gain = std::min<float>(setPoint / amp, maxGain);
                 }
                 else {
                     gain = 1.0f;
                 }
 
                 // If clipping is detected look ahead and correct
-                if (inAmp*gain > _maxOutputAmp) {
-                    float maxAmp = 0;
-                    for (int j = i; j < count; j++) {
-                        if constexpr (std::is_same_v<T, complex_t>) {
-                            inAmp = in[j].amplitude();
-                        }
-                        if constexpr (std::is_same_v<T, float>) {
-                            inAmp = fabsf(in[j]);
-                        }
-                        if (inAmp > maxAmp) { maxAmp = inAmp; }
+                if (inAmp*gain > maxOutputAmp) {
+                    if (!peaksReady) {
+                        computePeaks(i, count);
+                        peaksReady = true;
                     }
-                    amp = maxAmp;
-                    gain = std::min<float>(_setPoint / amp, _maxGain);
+                    amp = peaks[i];
+                    gain = std::min<float>(setPoint / amp, maxGain);
                 }
-                
-                // Scale output by gain
-                out[i] = in[i] * gain;
+
+                gains[i] = gain;
+            }
+            this->amp = amp;
+
+            // Scale output by gain
+            if constexpr (std::is_same_v<T, complex_t>) {
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)out, (lv_32fc_t*)in, gains, count);
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                volk_32f_x2_multiply_32f(out, in, gains, count);
             }
             return count;
         }
@@ -121,6 +157,47 @@ namespace dsp::loop {
         }
 
     protected:
+        void reserve(int count) {
+            if (count <= capacity) { return; }
+            if (capacity) {
+                buffer::free(amps);
+                buffer::free(gains);
+                buffer::free(peaks);
+                buffer::free(segMax);
+            }
+            amps = buffer::alloc<float>(count);
+            gains = buffer::alloc<float>(count);
+            peaks = buffer::alloc<float>(count);
+            segMax = buffer::alloc<float>(count);
+            capacity = count;
+        }
+
+        // Max amplitude over the look-ahead window of every sample from the given one to the end of the block, in O(n).
+        // The range is cut in segments as long as the window, so that a window is covered by the end of the segment it
+        // starts in and the start of the next one (van Herk/Gil-Werman).
+        void computePeaks(int from, int count) {
+            int window = (_lookAhead > 0) ? _lookAhead : count;
+
+            // Max from each sample to the end of its segment
+            for (int i = count - 1; i >= from; i--) {
+                bool segEnd = (i == count - 1) || !((i - from + 1) % window);
+                peaks[i] = segEnd ? amps[i] : std::max<float>(amps[i], peaks[i + 1]);
+            }
+
+            // Windows that don't fit in their segment also need the max from the start of the next segment
+            if (window >= count - from) { return; }
+            for (int i = from; i < count; i++) {
+                bool segStart = !((i - from) % window);
+                segMax[i] = segStart ? amps[i] : std::max<float>(amps[i], segMax[i - 1]);
+            }
+            for (int i = from; i < count; i++) {
+                int last = std::min<int>(i + window - 1, count - 1);
+                if ((last - from) / window != (i - from) / window) {
+                    peaks[i] = std::max<float>(peaks[i], segMax[last]);
+                }
+            }
+        }
+
         float _setPoint;
         float _attack;
         float _invAttack;
@@ -131,6 +208,14 @@ namespace dsp::loop {
         float _initGain;
 
         float amp = 1.0;
+        int _lookAhead = 0;
+
+        // Work buffers, they grow to fit the blocks
+        float* amps;
+        float* gains;
+        float* peaks;
+        float* segMax;
+        int capacity = 0;
 
     };
 }
\ No newline at end of file
@@ -14,10 +14,22 @@ namespace dsp::math {
             return count;
         }
 
+        bool canFuse() { return true; }
+
+        int processFused(int count, const complex_t* in, complex_t* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         virtual int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             base_type::_in->flush();
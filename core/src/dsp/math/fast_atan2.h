@@ -1,6 +1,8 @@
 #pragma once
 #include <math.h>
+#include <float.h>
 #include "constants.h"
+#include "../types.h"
 
 #define FAST_ATAN2_COEF1 FL_M_PI / 4.0f
 #define FAST_ATAN2_COEF2 3.0f * FAST_ATAN2_COEF1
@@ -23,4 +25,38 @@ namespace dsp::math {
         }
         return angle;
     }
-}
\ No newline at end of file
+
+    // Polynomial approximations of atan(z) for z between 0 and 1 (Abramowitz & Stegun 4.4.47 and 4.4.49)
+    inline float atanPoly5(float z) {
+        float s = z * z;
+        return z * (0.9998660f + s * (-0.3302995f + s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+    }
+
+    inline float atanPoly9(float z) {
+        float s = z * z;
+        return z * (1.0f + s * (-0.3333314528f + s * (0.1999355085f + s * (-0.1420889944f + s * (0.1065626393f
+                  + s * (-0.0752896400f + s * (0.0429096138f + s * (-0.0161657367f + s * 0.0028662257f))))))));
+    }
+
+    // Branchless atan2 built on one of the polynomials above, written so that compilers can vectorize loops calling it.
+    // The max error is about 1e-5 rad with 5 terms and comes down to float rounding with 9.
+    template <int TERMS>
+    inline float polyAtan2(float x, float y) {
+        float ax = fabsf(x);
+        float ay = fabsf(y);
+
+        // Choices are made with arithmetic instead of branches, compilers won't turn the branches into vector selects
+        // without being allowed to ignore floating point exceptions. steep and left are either 0 or 1.
+        float steep = (float)(ax < ay);
+        float left = (float)(x < 0.0f);
+        float num = steep * ax + (1.0f - steep) * ay;
+        float den = steep * ay + (1.0f - steep) * ax;
+
+        // The small offset avoids a division by zero, the ratio is then zero as well
+        float z = num / (den + FLT_MIN);
+        float angle = (TERMS == 5) ? atanPoly5(z) : atanPoly9(z);
+        angle = steep * (FL_M_PI / 2.0f) + (1.0f - 2.0f * steep) * angle;
+        angle = left * FL_M_PI + (1.0f - 2.0f * left) * angle;
+        return copysignf(angle, y);
+    }
+}
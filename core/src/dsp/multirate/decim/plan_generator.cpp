@@ -0,0 +1,96 @@
+#include "plan_generator.h"
+#include <map>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <math.h>
+#include <assert.h>
+#include "../../taps/low_pass.h"
+#include <utils/flog.h>
+
+// Usable bandwidth of the output as a fraction of its Nyquist frequency, matching the precomputed plans
+#define PLAN_GENERATOR_PASSBAND     0.9
+
+// Windowed sinc filters need more taps than the equiripple filters of the precomputed plans for a similar response
+#define PLAN_GENERATOR_TAP_FACTOR   1.5
+
+namespace dsp::multirate::decim {
+    namespace {
+        // The precomputed plans are designed for this same passband. Each stage only has to reject what would alias into
+        // the final passband, so early stages get wide transition bands and few taps while the last one sets the band edge.
+        // Rates are relative to the input samplerate.
+        int stageTapCount(double inRate, int decimation, double passband) {
+            double outRate = inRate / (double)decimation;
+            return PLAN_GENERATOR_TAP_FACTOR * taps::estimateTapCount(outRate - 2.0 * passband, inRate);
+        }
+
+        // The stages and taps are never freed, generated plans are cached until the program exits
+        plan generatePlan(unsigned int ratio) {
+            double passband = PLAN_GENERATOR_PASSBAND * 0.5 / (double)ratio;
+
+            // Find the cheapest order of factors. The cost of a stage is its tap count times its output rate, and the cost
+            // of what follows only depends on the ratio done so far, so going backward from the output over the divisors of
+            // the ratio finds the optimal plan without trying every factorization.
+            std::vector<unsigned int> divisors;
+            for (unsigned int d = 1; d <= ratio; d++) {
+                if (!(ratio % d)) { divisors.push_back(d); }
+            }
+            std::map<unsigned int, double> cost;
+            std::map<unsigned int, unsigned int> next;
+            cost[ratio] = 0.0;
+            for (int i = divisors.size() - 2; i >= 0; i--) {
+                unsigned int done = divisors[i];
+                double inRate = 1.0 / (double)done;
+                cost[done] = INFINITY;
+                for (unsigned int d = 2; d <= ratio / done; d++) {
+                    if ((ratio / done) % d) { continue; }
+                    double c = (double)stageTapCount(inRate, d, passband) * inRate / (double)d + cost[done * d];
+                    if (c < cost[done]) {
+                        cost[done] = c;
+                        next[done] = d;
+                    }
+                }
+            }
+
+            // Design a low-pass for each stage, centered between the passband and where aliasing into it starts
+            std::vector<stage> stages;
+            for (unsigned int done = 1; done < ratio; done *= next[done]) {
+                double inRate = 1.0 / (double)done;
+                int d = next[done];
+                double outRate = inRate / (double)d;
+                tap<float> taps = taps::windowedSinc<float>(stageTapCount(inRate, d, passband), outRate / 2.0, inRate, window::nuttall);
+                stages.push_back({ (unsigned int)d, (unsigned int)taps.size, taps.taps });
+            }
+
+            stage* list = new stage[stages.size()];
+            std::copy(stages.begin(), stages.end(), list);
+            return { (unsigned int)stages.size(), list };
+        }
+
+        std::mutex cacheMtx;
+        std::map<unsigned int, plan> cache;
+    }
+
+    plan getPlan(unsigned int ratio) {
+        assert(ratio >= 2);
+
+        // Powers of two have a precomputed plan
+        if (!(ratio & (ratio - 1))) {
+            int planId = log2(ratio) - 1;
+            if (planId < (int)plans_len) { return plans[planId]; }
+        }
+
+        std::lock_guard<std::mutex> lck(cacheMtx);
+        auto it = cache.find(ratio);
+        if (it != cache.end()) { return it->second; }
+
+        plan p = generatePlan(ratio);
+        std::string desc;
+        for (unsigned int i = 0; i < p.stageCount; i++) {
+            desc += (i ? ", " : "") + std::to_string(p.stages[i].decimation) + "x/" + std::to_string(p.stages[i].tapcount);
+        }
+        flog::info("Generated decimation plan for a ratio of {0}: {1}", ratio, desc);
+        cache[ratio] = p;
+        return p;
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "plans.h"
+
+namespace dsp::multirate::decim {
+    // Get the plan for any integer ratio of 2 or more. Powers of two use the optimized plans of plans.h, other ratios get a
+    // plan generated the first time they are asked for and cached for the lifetime of the program.
+    // Only integer ratios are covered. RationalResampler still does non-integer ratios with a power-of-two plan followed
+    // by its polyphase resampler.
+    plan getPlan(unsigned int ratio);
+}
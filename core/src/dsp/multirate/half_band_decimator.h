@@ -0,0 +1,198 @@
+#pragma once
+#include <vector>
+#include <math.h>
+#include "../processor.h"
+#include "../taps/tap.h"
+
+// Number of output floats computed together, kept in registers while going through all the taps
+#define HALF_BAND_DECIMATOR_BLOCK   16
+
+// Number of input samples split by phase at once
+#define HALF_BAND_DECIMATOR_CHUNK   4096
+
+namespace dsp::multirate {
+    // Decimation by two for the half-band stages of the decimation plans. The input is split into its even and odd
+    // samples so that each tap becomes a contiguous multiply-add over a run of outputs, which the compiler vectorizes,
+    // instead of one dot product per output. Taps that are zero, like every other tap of a true half-band filter, are
+    // skipped and symmetric pairs of taps share a single multiply.
+    // Outputs are the same as a DecimatingFIR with a decimation of two and the same taps, up to rounding.
+    template <class T>
+    class HalfBandDecimator : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        HalfBandDecimator() {}
+
+        HalfBandDecimator(stream<T>* in, tap<float>& taps) { init(in, taps); }
+
+        ~HalfBandDecimator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            freeBuffers();
+        }
+
+        void init(stream<T>* in, tap<float>& taps) {
+            _taps = taps;
+            hist = std::max<int>(_taps.size / 2, 1);
+            allocBuffers();
+            base_type::init(in);
+        }
+
+        void setTaps(tap<float>& taps) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _taps = taps;
+            hist = std::max<int>(_taps.size / 2, 1);
+            freeBuffers();
+            allocBuffers();
+            oddNext = false;
+            base_type::tempStart();
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            buffer::clear(even, hist);
+            buffer::clear(odd, hist);
+            oddNext = false;
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            // Split in chunks so that both phases stay in cache. Outputs never get ahead of the input, so in place
+            // processing only overwrites samples that were already split.
+            int outCount = 0;
+            for (int i = 0; i < count; i += HALF_BAND_DECIMATOR_CHUNK) {
+                outCount += processChunk(std::min<int>(HALF_BAND_DECIMATOR_CHUNK, count - i), &in[i], &out[outCount]);
+            }
+            return outCount;
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize / 2 + 1;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            base_type::prepareOutput(count);
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        static constexpr int FLOATS = sizeof(T) / sizeof(float);
+
+        int processChunk(int count, const T* in, T* out) {
+            // Split the input by phase. Outputs line up with even samples, and the odd sample that precedes an even one
+            // goes right before the new samples of the odd phase even when it ends up in the previous chunk.
+            int i = 0;
+            if (oddNext) { odd[hist - 1] = in[i++]; }
+            int outCount = 0;
+            for (; i + 1 < count; i += 2) {
+                even[hist + outCount] = in[i];
+                odd[hist + outCount] = in[i + 1];
+                outCount++;
+            }
+            oddNext = (i < count);
+            if (oddNext) { even[hist + outCount++] = in[i]; }
+
+            // Each output float is the sum of all terms, computed a few at a time to keep the sums in registers
+            int floats = outCount * FLOATS;
+            float* outf = (float*)out;
+            for (int f = 0; f < floats; f += HALF_BAND_DECIMATOR_BLOCK) {
+                float acc[HALF_BAND_DECIMATOR_BLOCK] = {};
+                for (const auto& t : terms) {
+                    const float* a = &t.a[f];
+                    const float* b = &t.b[f];
+                    for (int l = 0; l < HALF_BAND_DECIMATOR_BLOCK; l++) {
+                        acc[l] += t.coef * (a[l] + b[l]);
+                    }
+                }
+                memcpy(&outf[f], acc, std::min<int>(HALF_BAND_DECIMATOR_BLOCK, floats - f) * sizeof(float));
+            }
+
+            // Keep the history of both phases
+            memmove(even, &even[outCount], hist * sizeof(T));
+            memmove(odd, &odd[outCount], hist * sizeof(T));
+
+            return outCount;
+        }
+
+        // coef * (a + b) added to each output, with a == b and half the tap for taps that have no symmetric
+        struct Term {
+            float coef;
+            const float* a;
+            const float* b;
+        };
+
+        void allocBuffers() {
+            // Room for the history, the even samples of a chunk and the reads past the last output of the kernel
+            int size = hist + HALF_BAND_DECIMATOR_CHUNK / 2 + 1 + HALF_BAND_DECIMATOR_BLOCK;
+            even = buffer::alloc<T>(size);
+            odd = buffer::alloc<T>(size);
+            buffer::clear(even, size);
+            buffer::clear(odd, size);
+            buildTerms();
+        }
+
+        void freeBuffers() {
+            buffer::free(even);
+            buffer::free(odd);
+        }
+
+        // Output j is the sum of taps[k] * x[2j - (size - 1) + k], which falls on an even sample when size - 1 - k is
+        // even and on an odd sample otherwise.
+        const float* source(int k) {
+            int back = _taps.size - 1 - k;
+            if (back % 2) {
+                return (const float*)&odd[hist - (back + 1) / 2];
+            }
+            return (const float*)&even[hist - back / 2];
+        }
+
+        void buildTerms() {
+            terms.clear();
+            int size = _taps.size;
+            std::vector<bool> used(size, false);
+
+            // Designed half-band filters have rounding noise instead of exact zeros
+            float peak = 0.0f;
+            for (int k = 0; k < size; k++) {
+                peak = std::max<float>(peak, fabsf(_taps.taps[k]));
+            }
+            float zero = peak * 1e-9f;
+
+            for (int k = 0; k < size; k++) {
+                if (used[k]) { continue; }
+                used[k] = true;
+                if (fabsf(_taps.taps[k]) <= zero) { continue; }
+
+                // Pair with the symmetric tap when equal
+                int sym = size - 1 - k;
+                if (sym != k && !used[sym] && _taps.taps[sym] == _taps.taps[k]) {
+                    used[sym] = true;
+                    terms.push_back({ _taps.taps[k], source(k), source(sym) });
+                }
+                else {
+                    terms.push_back({ _taps.taps[k] * 0.5f, source(k), source(k) });
+                }
+            }
+        }
+
+        tap<float> _taps;
+        int hist;
+        T* even = NULL;
+        T* odd = NULL;
+        bool oddNext = false;
+        std::vector<Term> terms;
+    };
+}
@@ -2,6 +2,8 @@
 #include "../processor.h"
 #include "../taps/tap.h"
 #include "polyphase_bank.h"
+#include "../buffer/triple_buffer.h"
+#include "../buffer/delay_line.h"
 
 namespace dsp::multirate {
     template<class T>
@@ -15,8 +17,10 @@ namespace dsp::multirate {
         ~PolyphaseResampler() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
             freePolyphaseBank(phases);
+            for (int i = 0; i < pending.SLOT_COUNT; i++) {
+                freePolyphaseBank(pending[i].phases);
+            }
         }
 
         void init(stream<T>* in, int interp, int decim, tap<float> taps) {
@@ -27,10 +31,8 @@ namespace dsp::multirate {
             // Build filter bank
             phases = buildPolyphaseBank(_interp, _taps);
 
-            // Allocate delay buffer
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
-            bufStart = &buffer[phases.tapsPerPhase - 1];
-            buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
+            // The delay line holds the last samples of the previous block
+            delay.init(phases.tapsPerPhase - 1);
 
             base_type::init(in);
         }
@@ -38,29 +40,38 @@ namespace dsp::multirate {
         void setRatio(int interp, int decim, tap<float>& taps) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-
-            // Update settings
-            _interp = interp;
-            _decim = decim;
             _taps = taps;
 
-            // Re-generate polyphase bank
-            freePolyphaseBank(phases);
-            phases = buildPolyphaseBank(_interp, _taps);
+            // The bank is built here and swapped in by the DSP thread, the one it replaces comes back in the slot
+            Ratio& next = pending.back();
+            freePolyphaseBank(next.phases);
+            next.interp = interp;
+            next.decim = decim;
+            next.phases = buildPolyphaseBank(interp, taps);
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
 
-            // Reset buffer
-            bufStart = &buffer[phases.tapsPerPhase - 1];
-            reset();
+        bool update() {
+            if (!pending.update()) { return false; }
+            Ratio& next = pending.front();
+            _interp = next.interp;
+            _decim = next.decim;
+            std::swap(phases, next.phases);
 
-            base_type::tempStart();
+            // Start over with an empty delay line
+            delay.setLength(phases.tapsPerPhase - 1);
+            delay.clear();
+            phase = 0;
+            offset = 0;
+            return true;
         }
 
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
+            delay.clear();
             phase = 0;
             offset = 0;
             base_type::tempStart();
@@ -68,18 +79,39 @@ namespace dsp::multirate {
 
         inline int process(int count, const T* in, T* out) {
             int outCount = 0;
-
-            // Copy input to buffer
-            memcpy(bufStart, in, count * sizeof(T));
+            int spilled = 0;
+            int hist = phases.tapsPerPhase - 1;
+
+            // When resampling in place, either the input is copied first if there are more outputs than inputs, or
+            // the outputs that would overwrite input samples still needed are held back until the end
+            T* spill = NULL;
+            if (buffer::overlaps(in, count * sizeof(T), out, getOutputSize(count) * sizeof(T))) {
+                if (_interp > _decim) {
+                    T* copy = delay.spill(count);
+                    memcpy(copy, in, count * sizeof(T));
+                    in = copy;
+                }
+                else {
+                    spill = delay.spill(getOutputSize(count));
+                }
+            }
+            delay.begin(in, count);
 
             while (offset < count) {
+                T* dst = &out[outCount];
+                if (spill && outCount >= offset - hist) {
+                    dst = &spill[outCount];
+                    spilled = outCount + 1;
+                }
+
                 // Do convolution
                 if constexpr (std::is_same_v<T, float>) {
-                    volk_32f_x2_dot_prod_32f(&out[outCount++], &buffer[offset], phases.phases[phase], phases.tapsPerPhase);
+                    volk_32f_x2_dot_prod_32f(dst, delay.window(offset), phases.phases[phase], phases.tapsPerPhase);
                 }
                 if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
-                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)&buffer[offset], phases.phases[phase], phases.tapsPerPhase);
+                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)dst, (lv_32fc_t*)delay.window(offset), phases.phases[phase], phases.tapsPerPhase);
                 }
+                outCount++;
 
                 // Increment phase
                 phase += _decim;
@@ -91,17 +123,21 @@ namespace dsp::multirate {
                 phase = phase % _interp;
             }
             offset -= count;
+            if (spilled) { memcpy(out, spill, spilled * sizeof(T)); }
 
-            // Move delay
-            memmove(buffer, &buffer[count], (phases.tapsPerPhase - 1) * sizeof(T));
-
+            delay.end();
             return outCount;
         }
 
+        int getOutputSize(int inputSize) {
+            return (int)(((int64_t)inputSize * _interp) / _decim) + 1;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             // Swap if some data was generated
@@ -113,14 +149,20 @@ namespace dsp::multirate {
         }
 
     protected:
+        struct Ratio {
+            int interp;
+            int decim;
+            PolyphaseBank<float> phases;
+        };
+
         int _interp;
         int _decim;
         tap<float> _taps;
         PolyphaseBank<float> phases;
+        buffer::TripleBuffer<Ratio> pending;
         int phase = 0;
         int offset = 0;
-        T* buffer;
-        T* bufStart;
+        buffer::DelayLine<T> delay;
 
     };
 }
\ No newline at end of file
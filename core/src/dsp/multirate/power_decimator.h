@@ -1,27 +1,42 @@
 #pragma once
 #include "../filter/decimating_fir.h"
+#include "half_band_decimator.h"
 #include "../taps/from_array.h"
-#include "decim/plans.h"
+#include "decim/plan_generator.h"
+#include "../buffer/triple_buffer.h"
+#include "../convert/complex16_to_complex.h"
+#include <type_traits>
+
+// Number of samples converted at once when the input isn't of the output type
+#define POWER_DECIMATOR_CONVERT_CHUNK   4096
 
 namespace dsp::multirate {
-    template<class T>
-    class PowerDecimator : public Processor<T, T> {
-        using base_type = Processor<T, T>;
+    // Multistage decimation by any integer ratio. Powers of two use the precomputed plans, other ratios a generated one.
+    // The input can also be int16 complex samples (I = complex16_t, T = complex_t). They are then converted a cache
+    // sized chunk at a time right before the first stage, so only the decimated signal ever exists as floats in memory.
+    template<class T, class I = T>
+    class PowerDecimator : public Processor<I, T> {
+        using base_type = Processor<I, T>;
     public:
         PowerDecimator() {}
 
-        PowerDecimator(stream<T>* in, unsigned int ratio) { init(in, ratio); }
+        PowerDecimator(stream<I>* in, unsigned int ratio) { init(in, ratio); }
 
         ~PowerDecimator() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            freeFirs();
+            freeStages(stages);
+            for (int i = 0; i < pending.SLOT_COUNT; i++) {
+                freeStages(pending[i]);
+            }
+            if (conv) { buffer::free(conv); }
         }
 
-        void init(stream<T>* in, unsigned int ratio) {
+        void init(stream<I>* in, unsigned int ratio) {
             assert(checkRatio(ratio));
             _ratio = ratio;
-            reconfigure();
+            if constexpr (!std::is_same_v<I, T>) { conv = buffer::alloc<T>(POWER_DECIMATOR_CONVERT_CHUNK); }
+            buildStages(stages, _ratio);
             base_type::init(in);
         }
 
@@ -31,45 +46,90 @@ namespace dsp::multirate {
 
         void setRatio(unsigned int ratio) {
             assert(base_type::_block_init);
+            assert(checkRatio(ratio));
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _ratio = ratio;
-            reconfigure();
-            base_type::tempStart();
+
+            // The stages are built here and swapped in by the DSP thread, the ones they replace come back in the slot
+            Stages& next = pending.back();
+            freeStages(next);
+            buildStages(next, _ratio);
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            std::swap(stages, pending.front());
+            return true;
         }
 
         void reset() {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            for (auto& fir : decimFirs) {
-                fir->reset();
+            for (auto& stage : stages.list) {
+                if (stage.halfBand) { stage.halfBand->reset(); }
+                else { stage.fir->reset(); }
             }
             base_type::tempStart();
         }
 
-        inline int process(int count, const T* in, T* out) {
-            // If the ratio is 1, no need to decimate
-            if (_ratio == 1) {
-                memcpy(out, in, count * sizeof(T));
+        inline int process(int count, const I* in, T* out) {
+            if constexpr (std::is_same_v<I, T>) {
+                // If the ratio is 1, no need to decimate
+                if (stages.list.empty()) {
+                    memcpy(out, in, count * sizeof(T));
+                    return count;
+                }
+
+                // Process data through each stage
+                const T* data = in;
+                for (auto& stage : stages.list) {
+                    count = processStage(stage, count, data, out);
+                    data = out;
+                }
                 return count;
             }
-            
-            // Process data through each stage
-            const T* data = in;
-            int last = stageCount - 1;
-            for (int i = 0; i < stageCount; i++) {
-                auto fir = decimFirs[i];
-                count = fir->process(count, data, out);
-                data = out;
+            else {
+                // If the ratio is 1, only convert
+                if (stages.list.empty()) {
+                    return convert::Complex16ToComplex::process(count, in, out);
+                }
+
+                // Feed the first stage one converted chunk at a time, then run the others in place
+                int outCount = 0;
+                for (int i = 0; i < count; i += POWER_DECIMATOR_CONVERT_CHUNK) {
+                    int chunk = std::min<int>(POWER_DECIMATOR_CONVERT_CHUNK, count - i);
+                    convert::Complex16ToComplex::process(chunk, &in[i], conv);
+                    outCount += processStage(stages.list[0], chunk, conv, &out[outCount]);
+                }
+                for (int i = 1; i < (int)stages.list.size(); i++) {
+                    outCount = processStage(stages.list[i], outCount, out, out);
+                }
+                return outCount;
             }
-            return count;
+        }
+
+        int getOutputSize(int inputSize) {
+            // Stages after the first one work in place, so the first one writes the most
+            if (stages.list.empty()) { return inputSize; }
+            const Stage& first = stages.list[0];
+            return first.halfBand ? first.halfBand->getOutputSize(inputSize) : first.fir->getOutputSize(inputSize);
+        }
+
+        bool canFuse() { return true; }
+
+        int processFused(int count, const I* in, T* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
         }
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             // Swap if some data was generated
@@ -81,40 +141,59 @@ namespace dsp::multirate {
         }
 
     protected:
-        void freeFirs() {
-            for (auto& fir : decimFirs) { delete fir; }
-            for (auto& taps : decimTaps) { taps::free(taps); }
-            decimFirs.clear();
-            decimTaps.clear();
+        // Decimation by two stages get the dedicated kernel, the others a generic decimating FIR
+        struct Stage {
+            filter::DecimatingFIR<T, float>* fir = NULL;
+            HalfBandDecimator<T>* halfBand = NULL;
+        };
+
+        struct Stages {
+            std::vector<Stage> list;
+            std::vector<tap<float>> taps;
+        };
+
+        static inline int processStage(Stage& stage, int count, const T* in, T* out) {
+            return stage.halfBand ? stage.halfBand->process(count, in, out) : stage.fir->process(count, in, out);
         }
 
-        void reconfigure() {
-            // Delete DDC FIRs and taps
-            freeFirs();
+        static void freeStages(Stages& st) {
+            for (auto& stage : st.list) {
+                if (stage.fir) { delete stage.fir; }
+                if (stage.halfBand) { delete stage.halfBand; }
+            }
+            for (auto& taps : st.taps) { taps::free(taps); }
+            st.list.clear();
+            st.taps.clear();
+        }
 
+        static void buildStages(Stages& st, unsigned int ratio) {
             // Generate filters based on DDC plan
-            if (_ratio > 1) {
-                int planId = log2(_ratio) - 1;
-                decim::plan plan = decim::plans[planId];
-                stageCount = plan.stageCount;
-                for (int i = 0; i < stageCount; i++) {
-                    tap<float> taps = taps::fromArray<float>(plan.stages[i].tapcount, plan.stages[i].taps);
-                    auto fir = new filter::DecimatingFIR<T, float>(NULL, taps, plan.stages[i].decimation);
-                    fir->out.free();
-                    decimTaps.push_back(taps);
-                    decimFirs.push_back(fir);
+            if (ratio <= 1) { return; }
+            decim::plan plan = decim::getPlan(ratio);
+            for (int i = 0; i < plan.stageCount; i++) {
+                tap<float> taps = taps::fromArray<float>(plan.stages[i].tapcount, plan.stages[i].taps);
+                Stage stage;
+                if (plan.stages[i].decimation == 2) {
+                    stage.halfBand = new HalfBandDecimator<T>(NULL, taps);
+                    stage.halfBand->out.free();
+                }
+                else {
+                    stage.fir = new filter::DecimatingFIR<T, float>(NULL, taps, plan.stages[i].decimation);
+                    stage.fir->out.free();
                 }
+                st.taps.push_back(taps);
+                st.list.push_back(stage);
             }
         }
 
         bool checkRatio(unsigned int ratio) {
-            // Make sure ratio is a power of two, non-zero and lower or equal to maximum
-            return ((ratio & (ratio - 1)) == 0) && ratio && ratio <= getMaxRatio();
+            // Make sure ratio is non-zero and lower or equal to maximum
+            return ratio && ratio <= getMaxRatio();
         }
 
-        std::vector<filter::DecimatingFIR<T, float>*> decimFirs;
-        std::vector<tap<float>> decimTaps;
+        Stages stages;
+        buffer::TripleBuffer<Stages> pending;
         unsigned int _ratio;
-        int stageCount;
+        T* conv = NULL;
     };
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "power_decimator.h"
 #include "../taps/low_pass.h"
 #include "../window/nuttall.h"
+#include "../buffer/triple_buffer.h"
 
 namespace dsp::multirate {
     template<class T>
@@ -37,7 +38,7 @@ namespace dsp::multirate {
             resamp.out.free();
 
             // Proper configuration
-            reconfigure();
+            reconfigure(_inSamplerate, _outSamplerate);
 
             base_type::init(in);
         }
@@ -54,29 +55,29 @@ namespace dsp::multirate {
         void setInSamplerate(double inSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _inSamplerate = inSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            commit();
         }
 
         void setOutSamplerate(double outSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _outSamplerate = outSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            commit();
         }
 
         void setRates(double inSamplerate, double outSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
             _inSamplerate = inSamplerate;
             _outSamplerate = outSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            commit();
+        }
+
+        bool update() {
+            if (!pending.update()) { return false; }
+            reconfigure(pending.front().inSamplerate, pending.front().outSamplerate);
+            return true;
         }
 
         inline int process(int count, const T* in, T* out) {
@@ -95,10 +96,33 @@ namespace dsp::multirate {
             return count;
         }
 
+        int getOutputSize(int inputSize) {
+            switch(mode) {
+                case Mode::BOTH:
+                    inputSize = decim.getOutputSize(inputSize);
+                    return std::max<int>(inputSize, resamp.getOutputSize(inputSize));
+                case Mode::DECIM_ONLY:
+                    return decim.getOutputSize(inputSize);
+                case Mode::RESAMP_ONLY:
+                    return resamp.getOutputSize(inputSize);
+                case Mode::NONE:
+                    return inputSize;
+            }
+            return inputSize;
+        }
+
+        bool canFuse() { return true; }
+
+        int processFused(int count, const T* in, T* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             // Swap if some data was generated
@@ -117,29 +141,49 @@ namespace dsp::multirate {
             NONE
         };
 
-        void reconfigure() {
+        struct Rates {
+            double inSamplerate;
+            double outSamplerate;
+        };
+
+        // Hand the new rates to the DSP thread, or apply them right away if the resampler isn't running
+        void commit() {
+            pending.back() = { _inSamplerate, _outSamplerate };
+            pending.publish();
+            if (!base_type::updateDeferred()) { update(); }
+        }
+
+        // Only called by the thread running the resampler, the inner blocks aren't running so their settings apply immediately
+        void reconfigure(double inSamplerate, double outSamplerate) {
             // Calculate highest power-of-two decimation for the power decimator 
-            int predecPower = std::min<int>(floor(log2(_inSamplerate / _outSamplerate)), PowerDecimator<T>::getMaxRatio());
+            int predecPower = std::min<int>(floor(log2(inSamplerate / outSamplerate)), PowerDecimator<T>::getMaxRatio());
             int predecRatio = std::min<int>(1 << predecPower, PowerDecimator<T>::getMaxRatio());
-            double intSamplerate = _inSamplerate;
+            double intSamplerate = inSamplerate;
+
+            // Integer ratios are done entirely by the power decimator, the resampler isn't needed
+            double ratio = inSamplerate / outSamplerate;
+            int intRatio = round(ratio);
+            if (intRatio > 1 && intRatio <= (int)PowerDecimator<T>::getMaxRatio() && fabs(ratio - (double)intRatio) < 1e-9 * ratio) {
+                predecRatio = intRatio;
+            }
 
             // Configure the DDC
-            bool useDecim = (_inSamplerate > _outSamplerate && predecPower > 0);
+            bool useDecim = (inSamplerate > outSamplerate && predecRatio > 1);
             if (useDecim) {
-                intSamplerate = _inSamplerate / (double)predecRatio;
+                intSamplerate = inSamplerate / (double)predecRatio;
                 decim.setRatio(predecRatio);
             }
 
             // Calculate interpolation and decimation for polyphase resampler
             int IntSR = round(intSamplerate);
-            int OutSR = round(_outSamplerate);
+            int OutSR = round(outSamplerate);
             int gcd = std::gcd(IntSR, OutSR);
             int interp = OutSR / gcd;
             int decim = IntSR / gcd;
 
             // Check for excessive error
             double actualOutSR = (double)IntSR * (double)interp / (double)decim;
-            double error = abs((actualOutSR - _outSamplerate) / _outSamplerate) * 100.0;
+            double error = abs((actualOutSR - outSamplerate) / outSamplerate) * 100.0;
             if (error > 0.01) {
                 fprintf(stderr, "Warning: resampling error is over 0.01%%: %lf\n", error);
             }
@@ -152,7 +196,7 @@ namespace dsp::multirate {
 
             // Configure the polyphase resampler
             double tapSamplerate = intSamplerate * (double)interp;
-            double tapBandwidth = std::min<double>(_inSamplerate, _outSamplerate) / 2.0;
+            double tapBandwidth = std::min<double>(inSamplerate, outSamplerate) / 2.0;
             double tapTransWidth = tapBandwidth * 0.1;
             taps::free(rtaps);
             rtaps = taps::lowPass(tapBandwidth, tapTransWidth, tapSamplerate);
@@ -167,6 +211,7 @@ namespace dsp::multirate {
         PowerDecimator<T> decim;
         PolyphaseResampler<T> resamp;
         tap<float> rtaps;
+        buffer::TripleBuffer<Rates> pending;
         double _inSamplerate;
         double _outSamplerate;
         Mode mode;
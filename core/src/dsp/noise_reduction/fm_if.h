@@ -1,15 +1,21 @@
 #pragma once
+#include <vector>
 #include "../processor.h"
+#include "../buffer/delay_line.h"
 #include "../window/nuttall.h"
-#include <fftw3.h>
+#include "../fft/plan.h"
 
 namespace dsp::noise_reduction {
+    // Keeps only the strongest bin of a windowed FFT of the last samples. Since only one bin of the inverse FFT is
+    // non-zero, its output sample is that bin rotated by a fixed phase, so no inverse FFT is needed.
+    // The strongest bin is searched for once every hop samples, samples in between are the windowed DFT of that same
+    // bin, which is a single dot product. A hop of 1 searches on every sample like the original algorithm.
     class FMIF : public Processor<complex_t, complex_t> {
         using base_type = Processor<complex_t, complex_t>;
     public:
         FMIF() {}
 
-        FMIF(stream<complex_t>* in, int bins) { init(in, bins); }
+        FMIF(stream<complex_t>* in, int bins, int hop = 1) { init(in, bins, hop); }
 
         ~FMIF() {
             if (!base_type::_block_init) { return; }
@@ -17,9 +23,12 @@ namespace dsp::noise_reduction {
             destroyBuffers();
         }
 
-        void init(stream<complex_t>* in, int bins) {
+        void init(stream<complex_t>* in, int bins, int hop = 1) {
+            assert(hop > 0);
             _bins = bins;
+            _hop = hop;
             initBuffers();
+            delay.init(_bins - 1);
             base_type::init(in);
         }
 
@@ -30,6 +39,20 @@ namespace dsp::noise_reduction {
             _bins = bins;
             destroyBuffers();
             initBuffers();
+            delay.setLength(_bins - 1);
+            delay.clear();
+            bin = 0;
+            hopOffset = 0;
+            base_type::tempStart();
+        }
+
+        void setHop(int hop) {
+            assert(base_type::_block_init);
+            assert(hop > 0);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _hop = hop;
+            hopOffset = 0;
             base_type::tempStart();
         }
 
@@ -37,49 +60,77 @@ namespace dsp::noise_reduction {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            buffer::clear(buffer, _bins - 1);
-            buffer::clear(backFFTIn, _bins);
+            delay.clear();
+            bin = 0;
+            hopOffset = 0;
             base_type::tempStart();
         }
 
         int process(int count, const complex_t* in, complex_t* out) {
-            // Write new input data to buffer buffer
-            memcpy(bufferStart, in, count * sizeof(complex_t));
-            
-            // Iterate the FFT
-            for (int i = 0; i < count; i++) {
+            int maxHops = count / _hop + 1;
+            if ((int)hopBins.size() < maxHops) {
+                hopBins.resize(maxHops);
+                hopValues.resize(maxHops);
+            }
+            delay.begin(in, count);
+
+            // Find the strongest bin at the start of each hop. Nothing is written yet, so the input is still intact.
+            int hops = 0;
+            for (int i = hopOffset; i < count; i += _hop) {
                 // Apply windows
-                volk_32fc_32f_multiply_32fc((lv_32fc_t*)forwFFTIn, (lv_32fc_t*)&buffer[i], fftWin, _bins);
+                volk_32fc_32f_multiply_32fc((lv_32fc_t*)forwFFTIn, (lv_32fc_t*)delay.window(i), fftWin, _bins);
 
                 // Do forward FFT
-                fftwf_execute(forwardPlan);
+                forwardPlan.execute(forwFFTIn, forwFFTOut);
 
-                // Process bins here
+                // Keep only the bin of highest amplitude
                 uint32_t idx;
                 volk_32fc_magnitude_32f(ampBuf, (lv_32fc_t*)forwFFTOut, _bins);
                 volk_32f_index_max_32u(&idx, ampBuf, _bins);
+                hopBins[hops] = idx;
+                hopValues[hops] = forwFFTOut[idx] * rotation[idx];
+                hops++;
+            }
 
-                // Keep only the bin of highest amplitude
-                backFFTIn[idx] = forwFFTOut[idx];
-
-                // Do reverse FFT and get first element
-                fftwf_execute(backwardPlan);
-                out[i] = backFFTOut[_bins / 2];
-
-                // Reset the input buffer
-                backFFTIn[idx] = { 0, 0 };
+            // Outputs are generated backward so that in place processing only overwrites samples no longer needed
+            int i = count - 1;
+            for (int h = hops - 1; h >= 0; h--) {
+                int start = hopOffset + h * _hop;
+                const complex_t* taps = &binTaps[hopBins[h] * _bins];
+                for (; i > start; i--) {
+                    volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)delay.window(i), (lv_32fc_t*)taps, _bins);
+                }
+                out[i--] = hopValues[h];
             }
 
-            // Move buffer buffer
-            memmove(buffer, &buffer[count], (_bins - 1) * sizeof(complex_t));
+            // Samples before the first hop still belong to the last hop of the previous block
+            const complex_t* taps = &binTaps[bin * _bins];
+            for (; i >= 0; i--) {
+                volk_32fc_x2_dot_prod_32fc((lv_32fc_t*)&out[i], (lv_32fc_t*)delay.window(i), (lv_32fc_t*)taps, _bins);
+            }
+            if (hops) { bin = hopBins[hops - 1]; }
+            hopOffset += hops * _hop - count;
 
+            delay.end();
             return count;
         }
 
+        bool canFuse() { return true; }
+
+        int processFused(int count, const complex_t* in, complex_t* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
 
             // Swap if some data was generated
@@ -93,16 +144,6 @@ namespace dsp::noise_reduction {
             // Allocate FFT buffers
             forwFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
             forwFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTIn = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-            backFFTOut = (complex_t*)fftwf_malloc(_bins * sizeof(complex_t));
-
-            // Allocate and clear delay buffer
-            buffer = buffer::alloc<complex_t>(STREAM_BUFFER_SIZE + 64000);
-            bufferStart = &buffer[_bins - 1];
-            buffer::clear(buffer, _bins - 1);
-
-            // Clear backward FFT input since only one value is changed and reset at a time
-            buffer::clear(backFFTIn, _bins);
 
             // Allocate amplitude buffer
             ampBuf = buffer::alloc<float>(_bins);
@@ -111,39 +152,54 @@ namespace dsp::noise_reduction {
             fftWin = buffer::alloc<float>(_bins);
             for (int i = 0; i < _bins; i++) { fftWin[i] = window::nuttall(i, _bins - 1); }
 
+            // The inverse FFT of a single bin, taken at the center of the window, is the bin times a fixed rotation.
+            // Folding the rotation and the window into the DFT of each bin gives the taps used between hops.
+            rotation = buffer::alloc<complex_t>(_bins);
+            binTaps = buffer::alloc<complex_t>(_bins * _bins);
+            int center = _bins / 2;
+            for (int k = 0; k < _bins; k++) {
+                double rads = 2.0 * DB_M_PI * (double)((k * center) % _bins) / (double)_bins;
+                rotation[k] = { (float)cos(rads), (float)sin(rads) };
+                for (int n = 0; n < _bins; n++) {
+                    rads = -2.0 * DB_M_PI * (double)((k * (n - center + _bins)) % _bins) / (double)_bins;
+                    binTaps[k * _bins + n] = { (float)(fftWin[n] * cos(rads)), (float)(fftWin[n] * sin(rads)) };
+                }
+            }
+
             // Plan FFTs
-            forwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)forwFFTIn, (fftwf_complex*)forwFFTOut, FFTW_FORWARD, FFTW_ESTIMATE);
-            backwardPlan = fftwf_plan_dft_1d(_bins, (fftwf_complex*)backFFTIn, (fftwf_complex*)backFFTOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+            forwardPlan.acquire(_bins, FFTW_FORWARD);
         }
 
         void destroyBuffers() {
-            fftwf_destroy_plan(forwardPlan);
-            fftwf_destroy_plan(backwardPlan);
+            forwardPlan.release();
             fftwf_free(forwFFTIn);
             fftwf_free(forwFFTOut);
-            fftwf_free(backFFTIn);
-            fftwf_free(backFFTOut);
-            buffer::free(buffer);
             buffer::free(ampBuf);
             buffer::free(fftWin);
+            buffer::free(rotation);
+            buffer::free(binTaps);
         }
 
         complex_t* forwFFTIn;
         complex_t* forwFFTOut;
-        complex_t* backFFTIn;
-        complex_t* backFFTOut;
 
-        fftwf_plan forwardPlan;
-        fftwf_plan backwardPlan;
+        fft::Plan forwardPlan;
 
-        complex_t* buffer;
-        complex_t* bufferStart;
+        buffer::DelayLine<complex_t> delay;
 
         float* fftWin;
+        complex_t* rotation;
+        complex_t* binTaps;
 
         float* ampBuf;
 
+        std::vector<uint32_t> hopBins;
+        std::vector<complex_t> hopValues;
+
         int _bins;
+        int _hop;
+        int hopOffset = 0;
+        uint32_t bin = 0;
 
-    }; 
-}
\ No newline at end of file
+    };
+}
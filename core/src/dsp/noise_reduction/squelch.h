@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "../kernels/kernels.h"
 
 // TODO: Rewrite better!!!!!
 namespace dsp::noise_reduction {
@@ -10,17 +11,8 @@ namespace dsp::noise_reduction {
 
         Squelch(stream<complex_t>* in, double level) {}
 
-        ~Squelch() {
-            if (!base_type::_block_init) { return; }
-            base_type::stop();
-            buffer::free(normBuffer);
-        }
-
         void init(stream<complex_t>* in, double level) {
             _level = level;
-
-            normBuffer = buffer::alloc<float>(STREAM_BUFFER_SIZE);
-
             base_type::init(in);
         }
 
@@ -31,10 +23,7 @@ namespace dsp::noise_reduction {
         }
 
         inline int process(int count, const complex_t* in, complex_t* out) {
-            float sum;
-            volk_32fc_magnitude_32f(normBuffer, (lv_32fc_t*)in, count);
-            volk_32f_accumulator_s32f(&sum, normBuffer, count);
-            sum /= (float)count;
+            float sum = kernels::get().amplitudeSum(in, count) / (float)count;
 
             if (10.0f * log10f(sum) >= _level) {
                 memcpy(out, in, count * sizeof(complex_t));
@@ -46,11 +35,23 @@ namespace dsp::noise_reduction {
             return count;
         }
 
+        bool canFuse() { return true; }
+
+        int processFused(int count, const complex_t* in, complex_t* out) {
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            return process(count, in, out);
+        }
+
+        int getOutputSize(int inputSize) {
+            return inputSize;
+        }
+
         //DEFAULT_PROC_RUN();
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
+            base_type::prepareOutput(count);
             process(count, base_type::_in->readBuf, base_type::out.writeBuf);
             base_type::_in->flush();
             if (!base_type::out.swap(count)) { return -1; }
@@ -58,7 +59,6 @@ namespace dsp::noise_reduction {
         }
 
     private:
-        float* normBuffer;
         float _level = -50.0f;
                 
     };
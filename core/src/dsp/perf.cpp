@@ -0,0 +1,176 @@
+#include "perf.h"
+#include "block.h"
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <typeinfo>
+#include <utils/flog.h>
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+namespace dsp::perf {
+    struct Registry {
+        std::mutex mtx;
+        std::vector<block*> blocks;
+    };
+
+    // Never destroyed, blocks may still be stopped by static destructors after main() returns
+    Registry* reg = new Registry;
+
+    // Constant initialized, streams may be allocated by static constructors in other translation units
+    std::atomic<int64_t> bufferMemory(0);
+
+    std::string getTypeName(block* blk) {
+        const char* name = typeid(*blk).name();
+#ifdef __GNUC__
+        int status;
+        char* demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+        if (!demangled) { return name; }
+        std::string str = demangled;
+        ::free(demangled);
+        return str;
+#else
+        return name;
+#endif
+    }
+
+    void registerBlock(block* blk) {
+        std::lock_guard<std::mutex> lck(reg->mtx);
+        if (std::find(reg->blocks.begin(), reg->blocks.end(), blk) != reg->blocks.end()) { return; }
+        reg->blocks.push_back(blk);
+    }
+
+    void unregisterBlock(block* blk) {
+        std::lock_guard<std::mutex> lck(reg->mtx);
+        reg->blocks.erase(std::remove(reg->blocks.begin(), reg->blocks.end(), blk), reg->blocks.end());
+    }
+
+    std::vector<BlockStats> getStats() {
+        std::lock_guard<std::mutex> lck(reg->mtx);
+        std::vector<BlockStats> stats;
+        for (auto& blk : reg->blocks) {
+            BlockStats st;
+            st.id = blk;
+            st.name = blk->perfName.empty() ? getTypeName(blk) : blk->perfName;
+            st.runs = blk->perfRuns;
+            st.runTime = (double)blk->perfRunTime * 1e-9;
+            st.samplesIn = 0;
+            st.samplesOut = 0;
+            st.readWaitTime = 0.0;
+            st.swapWaitTime = 0.0;
+            st.fill = 0.0f;
+            for (auto& in : blk->inputs) {
+                if (!in) { continue; }
+                st.samplesIn += in->samplesSwapped;
+                st.readWaitTime += (double)in->readWaitTime * 1e-9;
+            }
+            for (auto& out : blk->outputs) {
+                if (!out) { continue; }
+                st.samplesOut += out->samplesSwapped;
+                st.swapWaitTime += (double)out->swapWaitTime * 1e-9;
+                int size = out->getBufferSize();
+                if (size > 0) { st.fill = std::max<float>(st.fill, (float)out->largestSwap / (float)size); }
+            }
+            st.processTime = std::max<double>(st.runTime - st.readWaitTime - st.swapWaitTime, 0.0);
+            stats.push_back(st);
+        }
+        return stats;
+    }
+
+    void resetStats() {
+        std::lock_guard<std::mutex> lck(reg->mtx);
+        for (auto& blk : reg->blocks) {
+            blk->perfRuns = 0;
+            blk->perfRunTime = 0;
+            for (auto& in : blk->inputs) {
+                if (!in) { continue; }
+                in->samplesSwapped = 0;
+                in->readWaitTime = 0;
+            }
+            for (auto& out : blk->outputs) {
+                if (!out) { continue; }
+                out->samplesSwapped = 0;
+                out->swapWaitTime = 0;
+                out->largestSwap = 0;
+            }
+        }
+    }
+
+    class Logger {
+    public:
+        ~Logger() {
+            setInterval(0);
+        }
+
+        void setInterval(int interval) {
+            {
+                std::lock_guard<std::mutex> lck(mtx);
+                if (interval == _interval) { return; }
+                _interval = interval;
+                stop = true;
+            }
+            cnd.notify_all();
+            if (thread.joinable()) { thread.join(); }
+
+            if (interval <= 0) { return; }
+            stop = false;
+            thread = std::thread(&Logger::worker, this);
+        }
+
+    private:
+        void worker() {
+            std::map<const void*, BlockStats> last;
+            uint64_t lastTime = now();
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lck(mtx);
+                    cnd.wait_for(lck, std::chrono::seconds(_interval), [this]() { return stop; });
+                    if (stop) { return; }
+                }
+
+                // Only log what happened since the last dump
+                uint64_t time = now();
+                double elapsed = (double)(time - lastTime) * 1e-9;
+                lastTime = time;
+                std::map<const void*, BlockStats> current;
+                for (auto& st : getStats()) {
+                    current[st.id] = st;
+                    auto it = last.find(st.id);
+                    bool known = (it != last.end() && st.samplesIn >= it->second.samplesIn && st.processTime >= it->second.processTime);
+                    double cpu = (st.processTime - (known ? it->second.processTime : 0.0)) * 100.0 / elapsed;
+                    double msps = (double)(st.samplesIn - (known ? it->second.samplesIn : 0)) * 1e-6 / elapsed;
+                    char buf[128];
+                    snprintf(buf, sizeof(buf), "%.2f%% CPU, %.3f MS/s in, %.1f%% max buffer fill", cpu, msps, st.fill * 100.0f);
+                    flog::info("[DSP Profiler] {0}: {1}", st.name, buf);
+                }
+                char mem[32];
+                snprintf(mem, sizeof(mem), "%.1f MB", (double)getBufferMemory() / 1e6);
+                flog::info("[DSP Profiler] Buffer memory: {0}", mem);
+                last = current;
+            }
+        }
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::thread thread;
+        int _interval = 0;
+        bool stop = false;
+    };
+
+    Logger logger;
+
+    void setLogInterval(int interval) {
+        logger.setInterval(interval);
+    }
+
+    void addBufferMemory(int64_t bytes) {
+        bufferMemory.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    int64_t getBufferMemory() {
+        return bufferMemory.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace dsp {
+    class block;
+
+    // Per-block performance counters. Streams count samples and time spent waiting,
+    // blocks count time spent in run(), running blocks are listed here.
+    namespace perf {
+        struct BlockStats {
+            const void* id;
+            std::string name;
+            uint64_t runs;
+            uint64_t samplesIn;
+            uint64_t samplesOut;
+            double runTime;         // Seconds spent in run(), waits included
+            double readWaitTime;    // Seconds spent waiting for input data
+            double swapWaitTime;    // Seconds spent waiting for the output to be read
+            double processTime;     // Seconds spent actually processing
+            float fill;             // Largest output buffer seen, relative to the buffer size
+        };
+
+        inline uint64_t now() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Demangled type name of a block, used when it wasn't given a name
+        std::string getTypeName(block* blk);
+
+        void registerBlock(block* blk);
+        void unregisterBlock(block* blk);
+
+        std::vector<BlockStats> getStats();
+        void resetStats();
+
+        // Log the CPU usage of every block at a fixed interval in seconds, zero disables logging
+        void setLogInterval(int interval);
+
+        // Total size in bytes of the sample buffers currently allocated by streams and buffering blocks
+        void addBufferMemory(int64_t bytes);
+        int64_t getBufferMemory();
+    }
+}
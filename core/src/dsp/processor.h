@@ -5,12 +5,14 @@
 // This is needed because not all process functions have the same arguments
 
 #define OVERRIDE_PROC_RUN(exp)\
+    int getOutputSize(int inputSize) { return inputSize; }\
     int run() {\
         int count = _in->read();\
         if (count < 0) {\
             return -1;\
         }\
         \
+        base_type::prepareOutput(count);\
         exp;\
         \
         base_type::_in->flush();\
@@ -25,6 +27,7 @@
             return -1;\
         }\
         \
+        base_type::prepareOutput(count);\
         int outCount = exp;\
         \
         base_type::_in->flush();\
@@ -66,9 +69,49 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Largest number of samples written to the output for a given input count, used to size the output buffer.
+        // Blocks that don't override it keep a full size output buffer.
+        virtual int getOutputSize(int inputSize) { return STREAM_BUFFER_SIZE; }
+
+        // Settings changed while the block is running are applied here by the DSP thread, between two blocks of samples,
+        // so that the stream never has to be stopped. Returns true if anything changed.
+        virtual bool update() { return false; }
+
+        // Blocks that can be run back-to-back by a fused chain (see FusedProcessor) override these two
+        virtual bool canFuse() { return false; }
+        virtual int processFused(int count, const I* in, O* out) { return -1; }
+
+        // Set by a FusedProcessor while it runs this block, settings are then applied by the fused thread
+        void setFused(bool fused) {
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            _fused = fused;
+        }
+
         stream<O> out;
 
     protected:
+        virtual void doStart() {
+            // Size the output for what the input can hold, this also happens when the block is reconfigured
+            update();
+            sizedFor = _in ? _in->getBufferSize() : STREAM_BUFFER_SIZE;
+            out.resize(std::clamp<int>(getOutputSize(sizedFor), 1, STREAM_BUFFER_SIZE));
+            block::doStart();
+        }
+
+        // Apply pending settings and grow the output if it can't hold the result, to be called by run() before writing to it
+        inline void prepareOutput(int inputCount) {
+            // New settings may change the output rate
+            if (update()) { sizedFor = 0; }
+            if (inputCount <= sizedFor) { return; }
+            sizedFor = std::min<int>(std::max<int>(inputCount, sizedFor * 2), STREAM_BUFFER_SIZE);
+            out.reserve(std::clamp<int>(getOutputSize(sizedFor), 1, STREAM_BUFFER_SIZE));
+        }
+
+        // Setters must leave the settings to update() when a DSP thread may be using the block
+        inline bool updateDeferred() { return running || _fused; }
+
         stream<I>* _in;
+        int sizedFor = STREAM_BUFFER_SIZE;
+        bool _fused = false;
     };
 }
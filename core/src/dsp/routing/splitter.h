@@ -1,5 +1,9 @@
 #pragma once
 #include "../sink.h"
+#include "../buffer/shared_buffer.h"
+
+// Maximum number of blocks in flight when in zero-copy mode
+#define SPLITTER_MAX_SHARED_BUFFERS (STREAM_MAX_SLOTS + 2)
 
 namespace dsp::routing {
     template <class T>
@@ -8,7 +12,21 @@ namespace dsp::routing {
     public:
         Splitter() {}
 
-        Splitter(stream<T>* in) { base_type::init(in); }
+        Splitter(stream<T>* in) { init(in); }
+
+        void init(stream<T>* in) {
+            pool.init(STREAM_BUFFER_SIZE, SPLITTER_MAX_SHARED_BUFFERS);
+            base_type::init(in);
+        }
+
+        // In zero-copy mode, all bound streams read the same reference counted buffer instead of getting their own copy
+        void setZeroCopy(bool enabled) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            zeroCopy = enabled;
+            base_type::tempStart();
+        }
 
         void bindStream(stream<T>* stream) {
             assert(base_type::_block_init);
@@ -47,7 +65,10 @@ namespace dsp::routing {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            if (zeroCopy) { return runShared(count); }
+
             for (const auto& stream : streams) {
+                stream->reserve(count);
                 memcpy(stream->writeBuf, base_type::_in->readBuf, count * sizeof(T));
                 if (!stream->swap(count)) {
                     base_type::_in->flush();
@@ -61,7 +82,50 @@ namespace dsp::routing {
         }
 
     protected:
+        int runShared(int count) {
+            // Copy the input once so that the upstream block can carry on immediately
+            buffer::SharedBuffer<T>* buf = pool.acquire(count);
+            if (!buf) {
+                base_type::_in->flush();
+                return -1;
+            }
+            memcpy(buf->data, base_type::_in->readBuf, count * sizeof(T));
+            base_type::_in->flush();
+
+            // Hand a reference to each output
+            for (const auto& stream : streams) {
+                buf->retain();
+                if (!stream->swapShared(buf, count)) {
+                    buf->release();
+                    buf->release();
+                    return -1;
+                }
+            }
+
+            // Drop our own reference, the last reader to flush returns the buffer to the pool
+            buf->release();
+
+            return count;
+        }
+
+        void doStart() {
+            // Outputs only need to hold what comes in, and nothing at all when they get shared buffers instead
+            int size = (zeroCopy || !base_type::_in) ? 0 : std::min<int>(base_type::_in->getBufferSize(), STREAM_BUFFER_SIZE);
+            for (const auto& stream : streams) {
+                stream->resize(size);
+            }
+            base_type::doStart();
+        }
+
+        void doStop() {
+            pool.stop();
+            base_type::doStop();
+            pool.clearStop();
+        }
+
         std::vector<stream<T>*> streams;
+        buffer::SharedBufferPool<T> pool;
+        bool zeroCopy = false;
 
     };
 }
\ No newline at end of file
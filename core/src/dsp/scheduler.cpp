@@ -0,0 +1,305 @@
+#include "scheduler.h"
+#include "block.h"
+#include "threading.h"
+#include <deque>
+#include <chrono>
+
+namespace dsp::scheduler {
+    enum TaskState {
+        TASK_IDLE,
+        TASK_QUEUED,
+        TASK_RUNNING
+    };
+
+    // Maximum number of run() calls in a row before a block goes back in the queue
+    const int MAX_RUNS_PER_SLICE = 8;
+
+    // Idle workers re-check the queues at this interval even if nobody woke them up
+    const std::chrono::milliseconds IDLE_TIMEOUT(10);
+
+    struct Worker {
+        int id;
+        std::thread thread;
+        std::mutex mtx;
+        std::deque<block*> queue;
+    };
+
+    thread_local Worker* currentWorker = NULL;
+
+    class Pool {
+    public:
+        void start(int threads) {
+            std::lock_guard<std::mutex> lck(mtx);
+            if (running) { return; }
+            target = (threads > 0) ? threads : std::max<int>(std::thread::hardware_concurrency(), 1);
+            target = std::min<int>(target, SCHEDULER_MAX_WORKERS);
+            for (int i = 0; i < target; i++) {
+                spawn();
+            }
+            running = true;
+        }
+
+        bool isRunning() {
+            return running;
+        }
+
+        int getThreadCount() {
+            return target;
+        }
+
+        void attach(block* blk) {
+            blk->schedState = TASK_IDLE;
+            blk->schedAttached = true;
+            for (auto& in : blk->inputs) {
+                in->readerTask = blk;
+            }
+            for (auto& out : blk->outputs) {
+                out->writerTask = blk;
+            }
+
+            // Data might already be waiting
+            notify(blk);
+        }
+
+        void detach(block* blk) {
+            blk->schedAttached = false;
+            for (auto& in : blk->inputs) {
+                block* expected = blk;
+                in->readerTask.compare_exchange_strong(expected, NULL);
+            }
+            for (auto& out : blk->outputs) {
+                block* expected = blk;
+                out->writerTask.compare_exchange_strong(expected, NULL);
+            }
+
+            // Wait for notifications that already picked up the block
+            for (auto& in : blk->inputs) {
+                while (in->pendingNotifies) { std::this_thread::yield(); }
+            }
+            for (auto& out : blk->outputs) {
+                while (out->pendingNotifies) { std::this_thread::yield(); }
+            }
+        }
+
+        void waitIdle(block* blk) {
+            std::unique_lock<std::mutex> lck(blk->schedMtx);
+            blk->schedCV.wait(lck, [blk]() { return blk->schedState == TASK_IDLE; });
+        }
+
+        void notify(block* blk) {
+            while (blk->schedAttached) {
+                // Blocks already queued or running will check their streams again anyway
+                int expected = TASK_IDLE;
+                if (!blk->schedState.compare_exchange_strong(expected, TASK_QUEUED)) { return; }
+                if (isReady(blk)) {
+                    push(blk);
+                    return;
+                }
+
+                // Not ready, check again in case a stream changed after isReady() but before the state went back to idle
+                blk->schedState = TASK_IDLE;
+                if (!isReady(blk)) { return; }
+            }
+        }
+
+        void beginBlocking() {
+            std::lock_guard<std::mutex> lck(mtx);
+            active--;
+            if (queued > 0) { wakeWorker(); }
+        }
+
+        void endBlocking() {
+            active++;
+        }
+
+    private:
+        bool isReady(block* blk) {
+            for (auto& in : blk->inputs) {
+                if (!in->readable()) { return false; }
+            }
+            for (auto& out : blk->outputs) {
+                if (!out->writable()) { return false; }
+            }
+            return true;
+        }
+
+        void push(block* blk) {
+            // Blocks woken up by a worker stay on it since their input is likely still in its cache
+            Worker* self = currentWorker;
+            if (self) {
+                std::lock_guard<std::mutex> lck(self->mtx);
+                self->queue.push_back(blk);
+            }
+            else {
+                std::lock_guard<std::mutex> lck(globalMtx);
+                globalQueue.push_back(blk);
+            }
+            queued++;
+
+            if (active < target) {
+                std::lock_guard<std::mutex> lck(mtx);
+                wakeWorker();
+            }
+        }
+
+        block* take(Worker* self) {
+            if (queued <= 0) { return NULL; }
+
+            // Newest local work first
+            {
+                std::lock_guard<std::mutex> lck(self->mtx);
+                if (!self->queue.empty()) {
+                    block* blk = self->queue.back();
+                    self->queue.pop_back();
+                    queued--;
+                    return blk;
+                }
+            }
+
+            // Then work coming from outside the pool
+            {
+                std::lock_guard<std::mutex> lck(globalMtx);
+                if (!globalQueue.empty()) {
+                    block* blk = globalQueue.front();
+                    globalQueue.pop_front();
+                    queued--;
+                    return blk;
+                }
+            }
+
+            // Then steal the oldest work of other workers
+            int count = workerCount;
+            for (int i = 1; i < count; i++) {
+                Worker* w = workers[(self->id + i) % count];
+                std::lock_guard<std::mutex> lck(w->mtx);
+                if (w->queue.empty()) { continue; }
+                block* blk = w->queue.front();
+                w->queue.pop_front();
+                queued--;
+                return blk;
+            }
+
+            return NULL;
+        }
+
+        void execute(block* blk) {
+            blk->schedState = TASK_RUNNING;
+            for (int i = 0; i < MAX_RUNS_PER_SLICE && blk->schedAttached && isReady(blk); i++) {
+                // Same as the worker thread of an unscheduled block exiting
+                if (blk->timedRun() < 0) {
+                    blk->schedAttached = false;
+                    break;
+                }
+            }
+
+            // The block may be deleted as soon as waitIdle() returns, so it must not be touched after unlocking
+            std::lock_guard<std::mutex> lck(blk->schedMtx);
+            blk->schedState = TASK_IDLE;
+            if (blk->schedAttached && isReady(blk)) { notify(blk); }
+            blk->schedCV.notify_all();
+        }
+
+        void workerLoop(Worker* self) {
+            currentWorker = self;
+
+            // Blocks move between workers, so thread policies apply to the workers as a whole
+            threading::setupCurrentThread("DSP Worker " + std::to_string(self->id));
+            while (true) {
+                // Workers above the target go to sleep, this happens when a blocked worker resumes
+                block* blk = (active <= target) ? take(self) : NULL;
+                if (blk) {
+                    execute(blk);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lck(mtx);
+                active--;
+                idle++;
+                cnd.wait_for(lck, IDLE_TIMEOUT, [this]() { return queued > 0 && active < target; });
+                idle--;
+                active++;
+            }
+        }
+
+        // Must be called with mtx locked
+        void wakeWorker() {
+            if (active >= target) { return; }
+            if (idle > 0) {
+                cnd.notify_one();
+                return;
+            }
+
+            // Every worker is busy or blocked, add one
+            spawn();
+        }
+
+        // Must be called with mtx locked
+        void spawn() {
+            int id = workerCount;
+            if (id >= SCHEDULER_MAX_WORKERS) { return; }
+            Worker* w = new Worker;
+            w->id = id;
+            workers[id] = w;
+            workerCount = id + 1;
+            active++;
+            w->thread = std::thread(&Pool::workerLoop, this, w);
+        }
+
+        std::mutex mtx;
+        std::condition_variable cnd;
+        std::atomic<bool> running = false;
+        int target = 0;
+        std::atomic<int> active = 0;
+        std::atomic<int> idle = 0;
+        std::atomic<int> queued = 0;
+
+        Worker* workers[SCHEDULER_MAX_WORKERS];
+        std::atomic<int> workerCount = 0;
+
+        std::mutex globalMtx;
+        std::deque<block*> globalQueue;
+    };
+
+    // Never destroyed, blocks may still be stopped by static destructors after main() returns
+    Pool* pool = new Pool;
+
+    void init(int threads) {
+        pool->start(threads);
+    }
+
+    bool isEnabled() {
+        return pool->isRunning();
+    }
+
+    int getThreadCount() {
+        return pool->getThreadCount();
+    }
+
+    void attach(block* blk) {
+        pool->attach(blk);
+    }
+
+    void detach(block* blk) {
+        pool->detach(blk);
+    }
+
+    void waitIdle(block* blk) {
+        pool->waitIdle(blk);
+    }
+
+    void notify(block* blk) {
+        pool->notify(blk);
+    }
+
+    bool isWorkerThread() {
+        return currentWorker != NULL;
+    }
+
+    void beginBlocking() {
+        pool->beginBlocking();
+    }
+
+    void endBlocking() {
+        pool->endBlocking();
+    }
+}
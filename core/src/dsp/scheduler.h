@@ -0,0 +1,32 @@
+#pragma once
+
+// Maximum number of worker threads, including the ones started to replace blocked workers
+#define SCHEDULER_MAX_WORKERS   256
+
+namespace dsp {
+    class block;
+
+    // Optional shared worker pool running block::run() whenever all of a block's streams are ready,
+    // instead of giving every block its own thread. Blocks pick it up when they are started.
+    namespace scheduler {
+        class Pool;
+
+        // Start the pool, zero threads means one per core
+        void init(int threads = 0);
+        bool isEnabled();
+        int getThreadCount();
+
+        // Used by dsp::block to hand itself to the pool and take itself back
+        void attach(block* blk);
+        void detach(block* blk);
+        void waitIdle(block* blk);
+
+        // Called by streams when a block they're connected to may have become ready
+        void notify(block* blk);
+
+        // Called by streams around a blocking wait so that another worker can take over
+        bool isWorkerThread();
+        void beginBlocking();
+        void endBlocking();
+    }
+}
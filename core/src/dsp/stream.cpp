@@ -0,0 +1,25 @@
+#include "stream.h"
+
+namespace dsp {
+    std::atomic<StreamMode> defaultMode = STREAM_MODE_DOUBLE_BUFFER;
+    std::atomic<int> defaultSlots = STREAM_DEFAULT_SLOTS;
+    std::atomic<int> defaultSpinCount = STREAM_DEFAULT_SPIN_COUNT;
+
+    void setDefaultStreamMode(StreamMode mode, int slots, int spinCount) {
+        defaultSlots = std::clamp<int>(slots, 2, STREAM_MAX_SLOTS);
+        defaultSpinCount = std::max<int>(spinCount, 0);
+        defaultMode = mode;
+    }
+
+    StreamMode getDefaultStreamMode() {
+        return defaultMode;
+    }
+
+    int getDefaultStreamSlots() {
+        return defaultSlots;
+    }
+
+    int getDefaultStreamSpinCount() {
+        return defaultSpinCount;
+    }
+}
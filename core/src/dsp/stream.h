@@ -1,14 +1,45 @@
 #pragma once
 #include <string.h>
+#include <algorithm>
 #include <mutex>
+#include <atomic>
+#include <thread>
 #include <condition_variable>
 #include <volk/volk.h>
 #include "buffer/buffer.h"
+#include "buffer/shared_buffer.h"
+#include "scheduler.h"
+#include "perf.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define DSP_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define DSP_CPU_RELAX() asm volatile("yield")
+#else
+#define DSP_CPU_RELAX()
+#endif
 
 // 1MSample buffer
 #define STREAM_BUFFER_SIZE 1000000
 
+// Ring stream defaults
+#define STREAM_DEFAULT_SLOTS        4
+#define STREAM_MAX_SLOTS            64
+#define STREAM_DEFAULT_SPIN_COUNT   2000
+
 namespace dsp {
+    enum StreamMode {
+        STREAM_MODE_DOUBLE_BUFFER,
+        STREAM_MODE_LOCK_FREE
+    };
+
+    // Global stream settings, streams pick them up the first time they are used
+    void setDefaultStreamMode(StreamMode mode, int slots = STREAM_DEFAULT_SLOTS, int spinCount = STREAM_DEFAULT_SPIN_COUNT);
+    StreamMode getDefaultStreamMode();
+    int getDefaultStreamSlots();
+    int getDefaultStreamSpinCount();
+
     class untyped_stream {
     public:
         virtual ~untyped_stream() {}
@@ -19,14 +50,47 @@ namespace dsp {
         virtual void clearWriteStop() {}
         virtual void stopReader() {}
         virtual void clearReadStop() {}
+
+        // Non-blocking state queries used by the scheduler, a stopped stream counts as ready
+        virtual bool readable() { return true; }
+        virtual bool writable() { return true; }
+
+        // Blocks to notify when the stream changes state, only set while they run on the scheduler
+        std::atomic<block*> readerTask = NULL;
+        std::atomic<block*> writerTask = NULL;
+        std::atomic<int> pendingNotifies = 0;
+
+        // Performance counters, wait times are in nanoseconds
+        virtual int getBufferSize() { return 0; }
+        std::atomic<uint64_t> samplesSwapped = 0;
+        std::atomic<uint64_t> readWaitTime = 0;
+        std::atomic<uint64_t> swapWaitTime = 0;
+        std::atomic<int> largestSwap = 0;
+
+    protected:
+        inline void countSwap(int size) {
+            samplesSwapped.fetch_add(size, std::memory_order_relaxed);
+            if (size > largestSwap.load(std::memory_order_relaxed)) { largestSwap.store(size, std::memory_order_relaxed); }
+        }
+
+        inline void notifyTask(std::atomic<block*>& task) {
+            if (!task.load(std::memory_order_relaxed)) { return; }
+            pendingNotifies++;
+            block* blk = task.load();
+            if (blk) { scheduler::notify(blk); }
+            pendingNotifies--;
+        }
     };
 
     template <class T>
     class stream : public untyped_stream {
     public:
         stream() {
-            writeBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
-            readBuf = buffer::alloc<T>(STREAM_BUFFER_SIZE);
+            bufferSize = STREAM_BUFFER_SIZE;
+            writeBuf = allocBuffer(bufferSize);
+            readBuf = allocBuffer(bufferSize);
+            writeCap = bufferSize;
+            readCap = bufferSize;
         }
 
         virtual ~stream() {
@@ -34,51 +98,137 @@ namespace dsp {
         }
 
         virtual void setBufferSize(int samples) {
-            buffer::free(writeBuf);
-            buffer::free(readBuf);
-            writeBuf = buffer::alloc<T>(samples);
-            readBuf = buffer::alloc<T>(samples);
+            free();
+            bufferSize = samples;
+            writeBuf = allocBuffer(bufferSize);
+            readBuf = allocBuffer(bufferSize);
+            writeCap = bufferSize;
+            readCap = bufferSize;
+        }
+
+        // Change the buffer size without disturbing the reader. Must only be called by the writer or while it is stopped,
+        // buffers currently held by the reader are reallocated once they come back to the writer.
+        void resize(int samples) {
+            std::lock_guard<std::mutex> lck(modeMtx);
+            samples = std::max<int>(samples, 0);
+            bufferSize = samples;
+            int m = mode.load();
+            if (m == STREAM_MODE_LOCK_FREE) {
+                int i = head.load() % slotCount;
+                if (slotCaps[i] != samples) {
+                    freeBuffer(slots[i], slotCaps[i]);
+                    slots[i] = allocBuffer(samples);
+                    slotCaps[i] = samples;
+                }
+                writeBuf = slots[i];
+                return;
+            }
+
+            if (writeCap != samples) {
+                freeBuffer(writeBuf, writeCap);
+                writeBuf = allocBuffer(samples);
+                writeCap = samples;
+            }
+
+            // Nothing was ever swapped before the mode is known, so the reader can't be holding readBuf
+            if (m < 0 && readCap != samples) {
+                freeBuffer(readBuf, readCap);
+                readBuf = allocBuffer(samples);
+                readCap = samples;
+            }
+        }
+
+        // Grow the buffers if they are smaller than the given size, same constraints as resize()
+        inline void reserve(int samples) {
+            if (samples > bufferSize) { resize(samples); }
         }
 
         virtual inline bool swap(int size) {
+            if (getMode() == STREAM_MODE_LOCK_FREE) { return ringSwap(size); }
+
             {
                 // Wait to either swap or stop
                 std::unique_lock<std::mutex> lck(swapMtx);
-                swapCV.wait(lck, [this] { return (canSwap || writerStop); });
+                blockingWait(swapCV, lck, [this] { return (canSwap || writerStop); }, &swapWaitTime);
 
                 // If writer was stopped, abandon operation
                 if (writerStop) { return false; }
 
                 // Swap buffers
                 dataSize = size;
-                T* temp = writeBuf;
-                writeBuf = readBuf;
-                readBuf = temp;
+                std::swap(writeBuf, readBuf);
+                std::swap(writeCap, readCap);
                 canSwap = false;
             }
 
+            // Catch up with a resize that happened while the reader was holding this buffer
+            if (writeCap != bufferSize) {
+                freeBuffer(writeBuf, writeCap);
+                writeBuf = allocBuffer(bufferSize);
+                writeCap = bufferSize;
+            }
+            countSwap(size);
+
             // Notify reader that some data is ready
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
                 dataReady = true;
             }
             rdyCV.notify_all();
+            notifyTask(readerTask);
+
+            return true;
+        }
+
+        // Publish a buffer shared with other streams instead of writeBuf, the stream keeps a reference until flushed
+        virtual inline bool swapShared(buffer::SharedBuffer<T>* shared, int size) {
+            if (getMode() == STREAM_MODE_LOCK_FREE) { return ringSwap(size, shared); }
+
+            {
+                // Wait to either swap or stop
+                std::unique_lock<std::mutex> lck(swapMtx);
+                blockingWait(swapCV, lck, [this] { return (canSwap || writerStop); }, &swapWaitTime);
+
+                // If writer was stopped, abandon operation
+                if (writerStop) { return false; }
+
+                // Point the reader to the shared buffer, writeBuf is left untouched
+                dataSize = size;
+                sharedRead = shared;
+                ownReadBuf = readBuf;
+                readBuf = shared->data;
+                canSwap = false;
+            }
+            countSwap(size);
+
+            // Notify reader that some data is ready
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                dataReady = true;
+            }
+            rdyCV.notify_all();
+            notifyTask(readerTask);
 
             return true;
         }
 
         virtual inline int read() {
+            if (getMode() == STREAM_MODE_LOCK_FREE) { return ringRead(); }
+
             // Wait for data to be ready or to be stopped
             std::unique_lock<std::mutex> lck(rdyMtx);
-            rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            blockingWait(rdyCV, lck, [this] { return (dataReady || readerStop); }, &readWaitTime);
 
             return (readerStop ? -1 : dataSize);
         }
 
         virtual inline void flush() {
-            // Clear data ready
+            if (getMode() == STREAM_MODE_LOCK_FREE) { ringFlush(); return; }
+
+            // Clear data ready and give back the shared buffer if there was one
             {
                 std::lock_guard<std::mutex> lck(rdyMtx);
+                if (dataReady && sharedRead) { releaseSharedRead(); }
                 dataReady = false;
             }
 
@@ -89,6 +239,7 @@ namespace dsp {
             }
 
             swapCV.notify_all();
+            notifyTask(writerTask);
         }
 
         virtual void stopWriter() {
@@ -97,6 +248,8 @@ namespace dsp {
                 writerStop = true;
             }
             swapCV.notify_all();
+            wakeParked();
+            notifyTask(writerTask);
         }
 
         virtual void clearWriteStop() {
@@ -109,34 +262,260 @@ namespace dsp {
                 readerStop = true;
             }
             rdyCV.notify_all();
+            wakeParked();
+            notifyTask(readerTask);
         }
 
         virtual void clearReadStop() {
             readerStop = false;
         }
 
+        virtual int getBufferSize() {
+            return bufferSize;
+        }
+
+        virtual bool readable() {
+            if (getMode() == STREAM_MODE_LOCK_FREE) { return head.load() != tail.load() || readerStop; }
+            return dataReady || readerStop;
+        }
+
+        virtual bool writable() {
+            if (getMode() == STREAM_MODE_LOCK_FREE) { return (head.load() + 1 - tail.load()) < (uint64_t)slotCount || writerStop; }
+            return canSwap || writerStop;
+        }
+
         void free() {
-            if (writeBuf) { buffer::free(writeBuf); }
-            if (readBuf) { buffer::free(readBuf); }
+            // Give back shared buffers that never got flushed
+            if (slotCount) {
+                for (uint64_t i = tail; i < head; i++) {
+                    if (!sharedSlots[i % slotCount]) { continue; }
+                    sharedSlots[i % slotCount]->release();
+                    sharedSlots[i % slotCount] = NULL;
+                }
+            }
+            else if (dataReady && sharedRead) {
+                releaseSharedRead();
+            }
+            dataReady = false;
+
+            // In ring mode every buffer is in a slot, writeBuf/readBuf only point to them
+            if (slotCount) {
+                for (int i = 0; i < slotCount; i++) {
+                    freeBuffer(slots[i], slotCaps[i]);
+                }
+            }
+            else {
+                freeBuffer(writeBuf, writeCap);
+                freeBuffer(readBuf, readCap);
+            }
             writeBuf = NULL;
             readBuf = NULL;
+            writeCap = 0;
+            readCap = 0;
+            bufferSize = 0;
+            slotCount = 0;
+            head = 0;
+            tail = 0;
+            mode = -1;
+        }
+
+        inline StreamMode getMode() {
+            int m = mode.load(std::memory_order_acquire);
+            if (m >= 0) { return (StreamMode)m; }
+            return resolveMode();
         }
 
         T* writeBuf;
         T* readBuf;
 
     private:
+        inline T* allocBuffer(int size) {
+            if (size <= 0) { return NULL; }
+            perf::addBufferMemory((int64_t)size * sizeof(T));
+            return buffer::alloc<T>(size);
+        }
+
+        inline void freeBuffer(T* buf, int size) {
+            if (!buf) { return; }
+            perf::addBufferMemory(-(int64_t)size * sizeof(T));
+            buffer::free(buf);
+        }
+
+        inline void releaseSharedRead() {
+            readBuf = ownReadBuf;
+            sharedRead->release();
+            sharedRead = NULL;
+        }
+
+        StreamMode resolveMode() {
+            // Both the reader and the writer can get here first, the first one decides for both
+            std::lock_guard<std::mutex> lck(modeMtx);
+            int m = mode.load(std::memory_order_relaxed);
+            if (m >= 0) { return (StreamMode)m; }
+
+            StreamMode newMode = getDefaultStreamMode();
+            if (newMode == STREAM_MODE_LOCK_FREE && (writeBuf || !writeCap) && (readBuf || !readCap)) {
+                // The writer may already be filling writeBuf, so it becomes slot 0 which it owns
+                slotCount = std::clamp<int>(getDefaultStreamSlots(), 2, STREAM_MAX_SLOTS);
+                spinCount = std::max<int>(getDefaultStreamSpinCount(), 0);
+                slots[0] = writeBuf;
+                slots[1] = readBuf;
+                slotCaps[0] = writeCap;
+                slotCaps[1] = readCap;
+                for (int i = 2; i < slotCount; i++) {
+                    slots[i] = allocBuffer(bufferSize);
+                    slotCaps[i] = bufferSize;
+                }
+                for (int i = 0; i < slotCount; i++) {
+                    sharedSlots[i] = NULL;
+                }
+                head = 0;
+                tail = 0;
+            }
+            else {
+                newMode = STREAM_MODE_DOUBLE_BUFFER;
+            }
+
+            mode.store(newMode, std::memory_order_release);
+            return newMode;
+        }
+
+        // Same as cv.wait(), but lets the scheduler replace the current worker while it sleeps
+        template <typename Func>
+        inline void blockingWait(std::condition_variable& cv, std::unique_lock<std::mutex>& lck, Func cond, std::atomic<uint64_t>* waitTime = NULL) {
+            if (cond()) { return; }
+            uint64_t start = waitTime ? perf::now() : 0;
+            bool worker = scheduler::isWorkerThread();
+            if (worker) { scheduler::beginBlocking(); }
+            cv.wait(lck, cond);
+            if (worker) { scheduler::endBlocking(); }
+            if (waitTime) { waitTime->fetch_add(perf::now() - start, std::memory_order_relaxed); }
+        }
+
+        void wakeParked() {
+            { std::lock_guard<std::mutex> lck(parkMtx); }
+            parkCV.notify_all();
+        }
+
+        template <typename Func>
+        inline bool spinWait(Func cond) {
+            for (int i = 0; i < spinCount; i++) {
+                if (cond()) { return true; }
+                DSP_CPU_RELAX();
+            }
+            return cond();
+        }
+
+        inline bool ringSwap(int size, buffer::SharedBuffer<T>* shared = NULL) {
+            // The writer always keeps one slot to itself, wait until another one is free
+            uint64_t h = head.load(std::memory_order_relaxed);
+            auto canPublish = [this, h] { return (h + 1 - tail.load(std::memory_order_acquire)) < (uint64_t)slotCount || writerStop; };
+            if (!canPublish()) {
+                uint64_t start = perf::now();
+                if (!spinWait(canPublish)) {
+                    std::unique_lock<std::mutex> lck(parkMtx);
+                    writerParked.store(true);
+                    blockingWait(parkCV, lck, canPublish);
+                    writerParked.store(false, std::memory_order_relaxed);
+                }
+                swapWaitTime.fetch_add(perf::now() - start, std::memory_order_relaxed);
+            }
+
+            // If writer was stopped, abandon operation
+            if (writerStop) { return false; }
+
+            // Publish the slot and move on to the next one
+            sizes[h % slotCount] = size;
+            sharedSlots[h % slotCount] = shared;
+            int next = (h + 1) % slotCount;
+            if (slotCaps[next] != bufferSize) {
+                // Catch up with a resize, the reader is done with this slot
+                freeBuffer(slots[next], slotCaps[next]);
+                slots[next] = allocBuffer(bufferSize);
+                slotCaps[next] = bufferSize;
+            }
+            writeBuf = slots[next];
+            head.store(h + 1);
+            countSwap(size);
+
+            // Only take the lock if the reader actually went to sleep
+            if (readerParked.load()) { wakeParked(); }
+            notifyTask(readerTask);
+
+            return true;
+        }
+
+        inline int ringRead() {
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            auto hasData = [this, t] { return head.load(std::memory_order_acquire) != t || readerStop; };
+            if (!hasData()) {
+                uint64_t start = perf::now();
+                if (!spinWait(hasData)) {
+                    std::unique_lock<std::mutex> lck(parkMtx);
+                    readerParked.store(true);
+                    blockingWait(parkCV, lck, hasData);
+                    readerParked.store(false, std::memory_order_relaxed);
+                }
+                readWaitTime.fetch_add(perf::now() - start, std::memory_order_relaxed);
+            }
+
+            if (readerStop) { return -1; }
+
+            buffer::SharedBuffer<T>* shared = sharedSlots[t % slotCount];
+            readBuf = shared ? shared->data : slots[t % slotCount];
+            return sizes[t % slotCount];
+        }
+
+        inline void ringFlush() {
+            // Flushing without data available is a no-op, same as the double buffer
+            uint64_t t = tail.load(std::memory_order_relaxed);
+            if (head.load(std::memory_order_acquire) == t) { return; }
+            buffer::SharedBuffer<T>* shared = sharedSlots[t % slotCount];
+            if (shared) {
+                sharedSlots[t % slotCount] = NULL;
+                shared->release();
+            }
+            tail.store(t + 1);
+
+            // Only take the lock if the writer actually went to sleep
+            if (writerParked.load()) { wakeParked(); }
+            notifyTask(writerTask);
+        }
+
+        // Double buffer
         std::mutex swapMtx;
         std::condition_variable swapCV;
-        bool canSwap = true;
+        std::atomic<bool> canSwap = true;
 
         std::mutex rdyMtx;
         std::condition_variable rdyCV;
-        bool dataReady = false;
+        std::atomic<bool> dataReady = false;
 
-        bool readerStop = false;
-        bool writerStop = false;
+        std::atomic<bool> readerStop = false;
+        std::atomic<bool> writerStop = false;
 
         int dataSize = 0;
+        int bufferSize;
+        int writeCap = 0;
+        int readCap = 0;
+        buffer::SharedBuffer<T>* sharedRead = NULL;
+        T* ownReadBuf = NULL;
+
+        // Lock-free ring
+        std::mutex modeMtx;
+        std::atomic<int> mode = -1;
+        T* slots[STREAM_MAX_SLOTS];
+        int slotCaps[STREAM_MAX_SLOTS];
+        int sizes[STREAM_MAX_SLOTS];
+        buffer::SharedBuffer<T>* sharedSlots[STREAM_MAX_SLOTS];
+        int slotCount = 0;
+        int spinCount = STREAM_DEFAULT_SPIN_COUNT;
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+
+        std::mutex parkMtx;
+        std::condition_variable parkCV;
+        std::atomic<bool> readerParked = false;
+        std::atomic<bool> writerParked = false;
     };
-}
\ No newline at end of file
+}
@@ -5,6 +5,7 @@
 #include "../window/nuttall.h"
 #include "../math/phasor.h"
 #include "../math/hz_to_rads.h"
+#include "tap_cache.h"
 
 namespace dsp::taps {
     template<class T>
@@ -13,14 +14,25 @@ namespace dsp::taps {
         float offsetOmega = math::hzToRads((bandStart + bandStop) / 2.0, sampleRate);
         int count = estimateTapCount(transWidth, sampleRate);
         if (oddTapCount && !(count % 2)) { count++; }
-        return windowedSinc<T>(count, (bandStop - bandStart) / 2.0, sampleRate, [=](double n, double N) {
-            if constexpr (std::is_same_v<T, float>) {
-                return 2.0f * cosf(offsetOmega * (float)n) * window::nuttall(n, N);
-            }
-            if constexpr (std::is_same_v<T, complex_t>) {
-                // The offset is negative to flip the taps. Complex bandpass are asymetric
-                return math::phasor(-offsetOmega * (float)n) * window::nuttall(n, N);
-            }
-        });
+        auto generator = [=]() {
+            return windowedSinc<T>(count, (bandStop - bandStart) / 2.0, sampleRate, [=](double n, double N) {
+                if constexpr (std::is_same_v<T, float>) {
+                    return 2.0f * cosf(offsetOmega * (float)n) * window::nuttall(n, N);
+                }
+                if constexpr (std::is_same_v<T, complex_t>) {
+                    // The offset is negative to flip the taps. Complex bandpass are asymetric
+                    return math::phasor(-offsetOmega * (float)n) * window::nuttall(n, N);
+                }
+            });
+        };
+
+        // Only real taps are cached
+        if constexpr (std::is_same_v<T, float>) {
+            TapKey key = { TAP_TYPE_BAND_PASS, TAP_WINDOW_NUTTALL, { bandStart, bandStop, transWidth, sampleRate }, count };
+            return cache::generate(key, generator);
+        }
+        else {
+            return generator();
+        }
     }
 }
\ No newline at end of file
@@ -2,13 +2,17 @@
 #include "windowed_sinc.h"
 #include "estimate_tap_count.h"
 #include "../window/nuttall.h"
+#include "tap_cache.h"
 
 namespace dsp::taps {
     inline tap<float> highPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount = false) {
         int count = estimateTapCount(transWidth, sampleRate);
         if (oddTapCount && !(count % 2)) { count++; }
-        return windowedSinc<float>(count, (sampleRate / 2.0) - cutoff, sampleRate, [=](double n, double N){
-            return window::nuttall(n, N) * (((int)round(n) % 2) ? -1.0f : 1.0f);
+        TapKey key = { TAP_TYPE_HIGH_PASS, TAP_WINDOW_NUTTALL, { cutoff, transWidth, sampleRate, 0.0 }, count };
+        return cache::generate(key, [=]() {
+            return windowedSinc<float>(count, (sampleRate / 2.0) - cutoff, sampleRate, [=](double n, double N){
+                return window::nuttall(n, N) * (((int)round(n) % 2) ? -1.0f : 1.0f);
+            });
         });
     }
 }
\ No newline at end of file
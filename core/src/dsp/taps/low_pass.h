@@ -2,11 +2,15 @@
 #include "windowed_sinc.h"
 #include "estimate_tap_count.h"
 #include "../window/nuttall.h"
+#include "tap_cache.h"
 
 namespace dsp::taps {
     inline tap<float> lowPass(double cutoff, double transWidth, double sampleRate, bool oddTapCount = false) {
         int count = estimateTapCount(transWidth, sampleRate);
         if (oddTapCount && !(count % 2)) { count++; }
-        return windowedSinc<float>(count, cutoff, sampleRate, window::nuttall);
+        TapKey key = { TAP_TYPE_LOW_PASS, TAP_WINDOW_NUTTALL, { cutoff, transWidth, sampleRate, 0.0 }, count };
+        return cache::generate(key, [=]() {
+            return cosineWindowedSinc(count, math::hzToRads(cutoff, sampleRate), window::NUTTALL_COEFS, window::NUTTALL_COEF_COUNT);
+        });
     }
 }
\ No newline at end of file
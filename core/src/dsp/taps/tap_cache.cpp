@@ -0,0 +1,74 @@
+#include "tap_cache.h"
+#include <list>
+#include <map>
+#include <mutex>
+#include <string.h>
+
+namespace dsp::taps::cache {
+    namespace {
+        struct KeyCompare {
+            bool operator()(const TapKey& a, const TapKey& b) const {
+                if (a.type != b.type) { return a.type < b.type; }
+                if (a.window != b.window) { return a.window < b.window; }
+                if (a.tapCount != b.tapCount) { return a.tapCount < b.tapCount; }
+                for (int i = 0; i < 4; i++) {
+                    if (a.params[i] != b.params[i]) { return a.params[i] < b.params[i]; }
+                }
+                return false;
+            }
+        };
+
+        struct Entry {
+            TapKey key;
+            tap<float> taps;
+        };
+
+        // Most recently used first
+        std::list<Entry> entries;
+        std::map<TapKey, std::list<Entry>::iterator, KeyCompare> index;
+        int64_t totalTaps = 0;
+        std::mutex mtx;
+    }
+
+    bool get(const TapKey& key, tap<float>& taps) {
+        std::lock_guard<std::mutex> lck(mtx);
+        auto it = index.find(key);
+        if (it == index.end()) { return false; }
+        entries.splice(entries.begin(), entries, it->second);
+        const tap<float>& cached = it->second->taps;
+        taps = taps::alloc<float>(cached.size);
+        memcpy(taps.taps, cached.taps, cached.size * sizeof(float));
+        return true;
+    }
+
+    void put(const TapKey& key, const tap<float>& taps) {
+        // Filters too large for the cache would only evict everything else
+        if (taps.size > TAP_CACHE_MAX_TAPS) { return; }
+
+        std::lock_guard<std::mutex> lck(mtx);
+        if (index.find(key) != index.end()) { return; }
+
+        Entry entry = { key, taps::alloc<float>(taps.size) };
+        memcpy(entry.taps.taps, taps.taps, taps.size * sizeof(float));
+        entries.push_front(entry);
+        index[key] = entries.begin();
+        totalTaps += taps.size;
+
+        // Evict the least recently used ones
+        while ((int)entries.size() > TAP_CACHE_MAX_ENTRIES || totalTaps > TAP_CACHE_MAX_TAPS) {
+            Entry& last = entries.back();
+            totalTaps -= last.taps.size;
+            index.erase(last.key);
+            taps::free(last.taps);
+            entries.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lck(mtx);
+        for (auto& entry : entries) { taps::free(entry.taps); }
+        entries.clear();
+        index.clear();
+        totalTaps = 0;
+    }
+}
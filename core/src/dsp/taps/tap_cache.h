@@ -0,0 +1,50 @@
+#pragma once
+#include "tap.h"
+
+// Max number of filters kept by the tap cache
+#define TAP_CACHE_MAX_ENTRIES   64
+
+// Max total number of taps kept by the tap cache
+#define TAP_CACHE_MAX_TAPS      (1 << 20)
+
+namespace dsp::taps {
+    enum TapType {
+        TAP_TYPE_LOW_PASS,
+        TAP_TYPE_HIGH_PASS,
+        TAP_TYPE_BAND_PASS
+    };
+
+    enum TapWindow {
+        TAP_WINDOW_NUTTALL
+    };
+
+    // Everything a generated filter depends on. Unused parameters are left at zero.
+    struct TapKey {
+        TapType type;
+        TapWindow window;
+        double params[4];
+        int tapCount;
+    };
+
+    // Least recently used filters, so that settings going back and forth don't regenerate the same taps every time.
+    // Callers get their own copy of the taps and free it like any other.
+    namespace cache {
+        // Copy the cached taps into newly allocated ones, returns false if they aren't cached
+        bool get(const TapKey& key, tap<float>& taps);
+
+        // Keep a copy of the taps, evicting the least recently used filters if full
+        void put(const TapKey& key, const tap<float>& taps);
+
+        void clear();
+
+        // Taps from the cache if there, otherwise from the generator and then cached
+        template <typename Func>
+        inline tap<float> generate(const TapKey& key, Func generator) {
+            tap<float> taps;
+            if (get(key, taps)) { return taps; }
+            taps = generator();
+            put(key, taps);
+            return taps;
+        }
+    }
+}
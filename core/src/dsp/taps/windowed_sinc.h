@@ -1,8 +1,16 @@
 #pragma once
 #include "tap.h"
+#include "../types.h"
 #include "../math/sinc.h"
 #include "../math/hz_to_rads.h"
 #include "../window/nuttall.h"
+#include <algorithm>
+
+// Number of taps cosineWindowedSinc generates side by side
+#define WINDOWED_SINC_LANES     8
+
+// Number of taps between exact computations of the phasors in cosineWindowedSinc
+#define WINDOWED_SINC_BLOCK     256
 
 namespace dsp::taps {
     template<class T, typename Func>
@@ -32,4 +40,78 @@ namespace dsp::taps {
     inline tap<T> windowedSinc(int count, double cutoff, double samplerate, Func window, double norm = 1.0) {
         return windowedSinc<T>(count, math::hzToRads(cutoff, samplerate), window, norm);
     }
+
+    // Same taps as windowedSinc with a cosine sum window (see window/cosine.h) given by its coefficients, generated
+    // without a sine or cosine call per tap. Each lane steps its own sinc and window phasors by rotation and the window
+    // harmonics come from Chebyshev polynomials of the window cosine, so the lanes vectorize. Phasors are recomputed
+    // exactly at the start of every block to keep the rounding errors from building up. Taps are symmetric, only the
+    // first half is generated.
+    inline tap<float> cosineWindowedSinc(int count, double omega, const double* coefs, int coefCount, double norm = 1.0) {
+        tap<float> taps = taps::alloc<float>(count);
+        double half = (double)count / 2.0;
+        double corr = norm * omega / DB_M_PI;
+        double winOmega = 2.0 * DB_M_PI / (double)count;
+        const int L = WINDOWED_SINC_LANES;
+        double sincStep[2] = { cos(L * omega), sin(L * omega) };
+        double winStep[2] = { cos(L * winOmega), sin(L * winOmega) };
+
+        int computed = (count + 1) / 2;
+        for (int b = 0; b < computed; b += WINDOWED_SINC_BLOCK) {
+            // Exact phasors of the first taps of the block, the window argument is the same as in windowedSinc modulo N
+            double sc[L], ss[L], wc[L], ws[L];
+            for (int l = 0; l < L; l++) {
+                double t = (double)(b + l) - half + 0.5;
+                sc[l] = cos(t * omega);
+                ss[l] = sin(t * omega);
+                wc[l] = cos(((double)(b + l) + 0.5) * winOmega);
+                ws[l] = sin(((double)(b + l) + 0.5) * winOmega);
+            }
+
+            int end = std::min<int>(b + WINDOWED_SINC_BLOCK, computed);
+            for (int i = b; i < end; i += L) {
+                // Window as a sum of cos(k * theta) = T_k(cos(theta))
+                double win[L], tPrev[L], tCur[L];
+                for (int l = 0; l < L; l++) {
+                    win[l] = coefs[0];
+                    tPrev[l] = 1.0;
+                    tCur[l] = wc[l];
+                }
+                double sign = -1.0;
+                for (int k = 1; k < coefCount; k++) {
+                    for (int l = 0; l < L; l++) {
+                        win[l] += sign * coefs[k] * tCur[l];
+                        double tNext = 2.0 * wc[l] * tCur[l] - tPrev[l];
+                        tPrev[l] = tCur[l];
+                        tCur[l] = tNext;
+                    }
+                    sign = -sign;
+                }
+
+                // Taps, then move every lane forward by L taps
+                double vals[L];
+                for (int l = 0; l < L; l++) {
+                    double x = ((double)(i + l) - half + 0.5) * omega;
+                    vals[l] = (ss[l] / x) * win[l] * corr;
+                    double c = sc[l];
+                    sc[l] = c * sincStep[0] - ss[l] * sincStep[1];
+                    ss[l] = ss[l] * sincStep[0] + c * sincStep[1];
+                    c = wc[l];
+                    wc[l] = c * winStep[0] - ws[l] * winStep[1];
+                    ws[l] = ws[l] * winStep[0] + c * winStep[1];
+                }
+                for (int l = 0; l < L && i + l < end; l++) { taps.taps[i + l] = vals[l]; }
+            }
+        }
+
+        // The center tap of odd filters is where the sinc is 1 and the division above isn't defined
+        if (count % 2) {
+            int center = count / 2;
+            taps.taps[center] = window::cosine((double)center - (double)count + 0.5, count, coefs, coefCount) * corr;
+        }
+
+        // Mirror the first half
+        for (int i = 0; i < count / 2; i++) { taps.taps[count - 1 - i] = taps.taps[i]; }
+
+        return taps;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "threading.h"
+#include <algorithm>
+#include <mutex>
+#include <string.h>
+#include <utils/flog.h>
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#endif
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace dsp::threading {
+    struct Rule {
+        std::string pattern;
+        Policy policy;
+    };
+
+    std::mutex rulesMtx;
+    std::vector<Rule> rules;
+
+    void addRule(const std::string& pattern, const Policy& policy) {
+        std::lock_guard<std::mutex> lck(rulesMtx);
+        rules.push_back({ pattern, policy });
+    }
+
+    void clearRules() {
+        std::lock_guard<std::mutex> lck(rulesMtx);
+        rules.clear();
+    }
+
+    std::string trim(const std::string& str) {
+        size_t begin = str.find_first_not_of(" \t");
+        if (begin == std::string::npos) { return ""; }
+        size_t end = str.find_last_not_of(" \t");
+        return str.substr(begin, end - begin + 1);
+    }
+
+    bool parseInt(const std::string& str, int& value) {
+        if (str.empty()) { return false; }
+        char* end;
+        value = strtol(str.c_str(), &end, 10);
+        return (*end == 0);
+    }
+
+    bool parseCPUList(const std::string& str, std::vector<int>& cpus) {
+        cpus.clear();
+        size_t pos = 0;
+        while (pos <= str.size()) {
+            size_t next = str.find(',', pos);
+            if (next == std::string::npos) { next = str.size(); }
+            std::string item = trim(str.substr(pos, next - pos));
+            pos = next + 1;
+
+            // Either a single CPU or a range
+            int first, last;
+            size_t dash = item.find('-');
+            if (dash == std::string::npos) {
+                if (!parseInt(item, first)) { return false; }
+                last = first;
+            }
+            else if (!parseInt(item.substr(0, dash), first) || !parseInt(item.substr(dash + 1), last)) {
+                return false;
+            }
+            if (first < 0 || last < first) { return false; }
+            for (int i = first; i <= last; i++) { cpus.push_back(i); }
+        }
+        return !cpus.empty();
+    }
+
+    bool parseRules(const std::string& str) {
+        size_t pos = 0;
+        while (pos < str.size()) {
+            size_t next = str.find(';', pos);
+            if (next == std::string::npos) { next = str.size(); }
+            std::string item = trim(str.substr(pos, next - pos));
+            pos = next + 1;
+            if (item.empty()) { continue; }
+
+            // The pattern is separated from the options by an equal sign
+            size_t eq = item.find('=');
+            if (eq == std::string::npos) {
+                flog::error("Invalid thread policy '{0}', expected <pattern>=<options>", item);
+                return false;
+            }
+            std::string pattern = trim(item.substr(0, eq));
+
+            // Options are space separated key:value pairs
+            Policy policy;
+            std::string opts = item.substr(eq + 1);
+            size_t optPos = 0;
+            while (optPos < opts.size()) {
+                size_t optNext = opts.find(' ', optPos);
+                if (optNext == std::string::npos) { optNext = opts.size(); }
+                std::string opt = opts.substr(optPos, optNext - optPos);
+                optPos = optNext + 1;
+                if (opt.empty()) { continue; }
+
+                size_t colon = opt.find(':');
+                std::string key = opt.substr(0, colon);
+                std::string val = (colon != std::string::npos) ? opt.substr(colon + 1) : "";
+                bool valid = false;
+                if (key == "cpus") {
+                    valid = parseCPUList(val, policy.cpus);
+                }
+                else if (key == "fifo") {
+                    valid = parseInt(val, policy.fifoPriority) && policy.fifoPriority >= 1 && policy.fifoPriority <= 99;
+                }
+                else if (key == "nice") {
+                    valid = parseInt(val, policy.nice) && policy.nice >= -20 && policy.nice <= 19;
+                    policy.setNice = true;
+                }
+                if (!valid) {
+                    flog::error("Invalid thread policy option '{0}' for '{1}'", opt, pattern);
+                    return false;
+                }
+            }
+
+            addRule(pattern, policy);
+        }
+        return true;
+    }
+
+    bool match(const char* pattern, const char* str) {
+        if (!*pattern) { return !*str; }
+        if (*pattern == '*') {
+            // Try every possible length for the wildcard
+            for (const char* s = str; ; s++) {
+                if (match(pattern + 1, s)) { return true; }
+                if (!*s) { return false; }
+            }
+        }
+        if (!*str) { return false; }
+        if (*pattern != '?' && *pattern != *str) { return false; }
+        return match(pattern + 1, str + 1);
+    }
+
+    // OS thread names are short, so namespaces and template arguments of type names are dropped
+    std::string shortName(const std::string& name) {
+        std::string str = name.substr(0, name.find('<'));
+        size_t ns = str.rfind("::");
+        if (ns != std::string::npos) { str = str.substr(ns + 2); }
+        return str.substr(0, 15);
+    }
+
+    void setName(const std::string& name) {
+        std::string str = shortName(name);
+#if defined(_WIN32)
+        // Only available starting with Windows 10
+        typedef HRESULT (WINAPI *SetThreadDescription_t)(HANDLE, PCWSTR);
+        static SetThreadDescription_t setDesc = (SetThreadDescription_t)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+        if (!setDesc) { return; }
+        std::wstring wstr(str.begin(), str.end());
+        setDesc(GetCurrentThread(), wstr.c_str());
+#elif defined(__APPLE__)
+        pthread_setname_np(str.c_str());
+#else
+        pthread_setname_np(pthread_self(), str.c_str());
+#endif
+    }
+
+    void setAffinity(const std::string& name, const std::vector<int>& cpus) {
+#if defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for (int cpu : cpus) {
+            if (cpu < (int)(sizeof(DWORD_PTR) * 8)) { mask |= ((DWORD_PTR)1) << cpu; }
+        }
+        if (!mask || !SetThreadAffinityMask(GetCurrentThread(), mask)) {
+            flog::warn("Could not set the CPU affinity of thread '{0}'", name);
+        }
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+        }
+        if (sched_setaffinity(0, sizeof(set), &set)) {
+            flog::warn("Could not set the CPU affinity of thread '{0}': {1}", name, strerror(errno));
+        }
+#else
+        flog::warn("CPU affinity is not supported on this platform, ignored for thread '{0}'", name);
+#endif
+    }
+
+    void setPriority(const std::string& name, const Policy& policy) {
+#if defined(_WIN32)
+        // Windows has no equivalent to SCHED_FIFO, map to the closest thread priority
+        int prio = THREAD_PRIORITY_NORMAL;
+        if (policy.fifoPriority) {
+            prio = THREAD_PRIORITY_TIME_CRITICAL;
+        }
+        else if (policy.setNice && policy.nice) {
+            if (policy.nice <= -10) { prio = THREAD_PRIORITY_HIGHEST; }
+            else if (policy.nice < 0) { prio = THREAD_PRIORITY_ABOVE_NORMAL; }
+            else if (policy.nice < 10) { prio = THREAD_PRIORITY_BELOW_NORMAL; }
+            else { prio = THREAD_PRIORITY_LOWEST; }
+        }
+        if (!SetThreadPriority(GetCurrentThread(), prio)) {
+            flog::warn("Could not set the priority of thread '{0}'", name);
+        }
+#else
+        if (policy.fifoPriority) {
+            // Usually requires CAP_SYS_NICE or a matching RLIMIT_RTPRIO
+            sched_param param = {};
+            param.sched_priority = policy.fifoPriority;
+            int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (err) {
+                flog::warn("Could not set SCHED_FIFO priority {0} for thread '{1}': {2}", policy.fifoPriority, name, strerror(err));
+            }
+        }
+        if (policy.setNice) {
+#if defined(__linux__)
+            // On Linux, the nice value is per thread
+            if (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), policy.nice)) {
+                flog::warn("Could not set nice value {0} for thread '{1}': {2}", policy.nice, name, strerror(errno));
+            }
+#else
+            flog::warn("Per-thread nice values are not supported on this platform, ignored for thread '{0}'", name);
+#endif
+        }
+#endif
+    }
+
+    void setupCurrentThread(const std::string& name) {
+        setName(name);
+
+        // Find the first matching rule
+        Policy policy;
+        std::string pattern;
+        {
+            std::lock_guard<std::mutex> lck(rulesMtx);
+            auto it = std::find_if(rules.begin(), rules.end(), [&name](const Rule& r) { return match(r.pattern.c_str(), name.c_str()); });
+            if (it == rules.end()) { return; }
+            policy = it->policy;
+            pattern = it->pattern;
+        }
+
+        flog::info("Applying thread policy '{0}' to thread '{1}'", pattern, name);
+        if (!policy.cpus.empty()) { setAffinity(name, policy.cpus); }
+        if (policy.fifoPriority || policy.setNice) { setPriority(name, policy); }
+    }
+
+    void setupCallbackThread(const std::string& name) {
+        thread_local std::string current;
+        if (name == current) { return; }
+        current = name;
+        setupCurrentThread(name);
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace dsp {
+    // Per-thread CPU affinity and priority. Threads call setupCurrentThread() with a descriptive name when they start,
+    // which names the thread for the OS (shown by top -H, perf or a debugger) and applies the first rule matching it.
+    namespace threading {
+        struct Policy {
+            std::vector<int> cpus;      // CPUs the thread may run on, empty to leave the affinity alone
+            int fifoPriority = 0;       // SCHED_FIFO priority between 1 and 99, zero to keep the normal scheduler
+            bool setNice = false;
+            int nice = 0;               // Only applied if setNice is true
+        };
+
+        // Rules are matched in the order they were added, '*' and '?' can be used as wildcards in the pattern
+        void addRule(const std::string& pattern, const Policy& policy);
+        void clearRules();
+
+        // Parse a list of rules like "VFO *=cpus:4-7 fifo:40; IQ Splitter=cpus:2,3 nice:-5" and add them
+        bool parseRules(const std::string& rules);
+
+        // Parse a CPU list like "0-3,8" into cpu numbers
+        bool parseCPUList(const std::string& str, std::vector<int>& cpus);
+
+        // Name the calling thread and apply the policy of the first rule matching the name
+        void setupCurrentThread(const std::string& name);
+
+        // Same as setupCurrentThread(), for callbacks run on a thread owned by a driver or library. Only the first call on
+        // a thread, or one with a different name, does anything, so it can be called every time the callback runs.
+        void setupCallbackThread(const std::string& name);
+    }
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <math.h>
+#include <stdint.h>
 #include "math/constants.h"
 
 namespace dsp {
@@ -125,4 +126,10 @@ namespace dsp {
         float l;
         float r;
     };
-}
+
+    // Raw 16 bit IQ as delivered by most SDR hardware, full scale (32768) maps to 1.0 once converted to complex_t
+    struct complex16_t {
+        int16_t re;
+        int16_t im;
+    };
+}
\ No newline at end of file
@@ -2,8 +2,10 @@
 #include "cosine.h"
 
 namespace dsp::window {
+    constexpr double NUTTALL_COEFS[] = { 0.355768, 0.487396, 0.144232, 0.012604 };
+    constexpr int NUTTALL_COEF_COUNT = sizeof(NUTTALL_COEFS) / sizeof(double);
+
     inline double nuttall(double n, double N) {
-        const double coefs[] = { 0.355768, 0.487396, 0.144232, 0.012604 };
-        return cosine(n, N, coefs, sizeof(coefs) / sizeof(double));
+        return cosine(n, N, NUTTALL_COEFS, NUTTALL_COEF_COUNT);
     }
 }
\ No newline at end of file
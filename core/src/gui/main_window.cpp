@@ -20,6 +20,7 @@
 #include <gui/menus/vfo_color.h>
 #include <gui/menus/module_manager.h>
 #include <gui/menus/theme.h>
+#include <gui/menus/dsp_profiler.h>
 #include <gui/dialogs/credits.h>
 #include <filesystem>
 #include <signal_path/source.h>
@@ -77,6 +78,7 @@ void MainWindow::init() {
     gui::menu.registerEntry("Theme", thememenu::draw, NULL);
     gui::menu.registerEntry("VFO Color", vfo_color_menu::draw, NULL);
     gui::menu.registerEntry("Module Manager", module_manager_menu::draw, NULL);
+    gui::menu.registerEntry("DSP Profiler", dsp_profiler_menu::draw, NULL);
 
     gui::freqSelect.init();
 
@@ -84,10 +86,6 @@ void MainWindow::init() {
     gui::waterfall.setBandwidth(8000000);
     gui::waterfall.setViewBandwidth(8000000);
 
-    fft_in = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
-    fft_out = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * fftSize);
-    fftwPlan = fftwf_plan_dft_1d(fftSize, fft_in, fft_out, FFTW_FORWARD, FFTW_ESTIMATE);
-
     sigpath::iqFrontEnd.init(&dummyStream, 8000000, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, acquireFFTBuffer, releaseFFTBuffer, this);
     sigpath::iqFrontEnd.start();
 
@@ -169,6 +167,7 @@ void MainWindow::init() {
     displaymenu::init();
     vfo_color_menu::init();
     module_manager_menu::init();
+    dsp_profiler_menu::init();
 
     // TODO for 0.2.5
     // Fix gain not updated on startup, soapysdr
@@ -228,11 +227,11 @@ void MainWindow::init() {
 }
 
 float* MainWindow::acquireFFTBuffer(void* ctx) {
-    return gui::waterfall.getFFTBuffer();
+    return gui::waterfall.getFFTBuffer(sigpath::iqFrontEnd.getDeliveredFFTView());
 }
 
 void MainWindow::releaseFFTBuffer(void* ctx) {
-    gui::waterfall.pushFFT();
+    gui::waterfall.pushFFT(sigpath::iqFrontEnd.getDeliveredFFTView());
 }
 
 void MainWindow::vfoAddedHandler(VFOManager::VFO* vfo, void* ctx) {
@@ -549,6 +548,13 @@ void MainWindow::draw() {
 
     ImGui::EndChild();
 
+    // Have the front end reduce the spectrum to what's on screen now
+    dsp::fft::SpectrumView fftView = gui::waterfall.getFFTView();
+    if (fftView != lastFFTView) {
+        sigpath::iqFrontEnd.setFFTView(fftView);
+        lastFFTView = fftView;
+    }
+
     if (!lockWaterfallControls) {
         // Handle arrow keys
         if (vfo != NULL && (gui::waterfall.mouseInFFT || gui::waterfall.mouseInWaterfall)) {
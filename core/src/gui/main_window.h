@@ -8,6 +8,7 @@
 #include <utils/event.h>
 #include <mutex>
 #include <gui/tuner.h>
+#include <dsp/fft/spectrum_pipeline.h>
 
 #define WINDOW_FLAGS ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBackground
 
@@ -39,8 +40,7 @@ private:
     // FFT Variables
     int fftSize = 8192 * 8;
     std::mutex fft_mtx;
-    fftwf_complex *fft_in, *fft_out;
-    fftwf_plan fftwPlan;
+    dsp::fft::SpectrumView lastFFTView;
 
     // GUI Variables
     bool firstMenuRender = true;
@@ -20,6 +20,11 @@ namespace displaymenu {
     int selectedWindow = 0;
     int fftRate = 20;
     int fftSizeId = 0;
+    int fftAverages = 1;
+    int fftOverlap = 50;
+    bool fftReduce = false;
+    int fftReduceMode = 0;
+    bool fftZoom = true;
     int uiScaleId = 0;
     bool restartRequired = false;
     bool fftHold = false;
@@ -88,9 +93,22 @@ namespace displaymenu {
         fftRate = core::configManager.conf["fftRate"];
         sigpath::iqFrontEnd.setFFTRate(fftRate);
 
+        sigpath::iqFrontEnd.setFFTThreads(core::configManager.conf["fftThreads"]);
+
         selectedWindow = std::clamp<int>((int)core::configManager.conf["fftWindow"], 0, (sizeof(fftWindowList) / sizeof(IQFrontEnd::FFTWindow)) - 1);
         sigpath::iqFrontEnd.setFFTWindow(fftWindowList[selectedWindow]);
 
+        fftAverages = std::max<int>((int)core::configManager.conf["fftAverages"], 1);
+        fftOverlap = std::clamp<int>((int)core::configManager.conf["fftOverlap"], 0, 95);
+        sigpath::iqFrontEnd.setFFTAverages(fftAverages);
+        sigpath::iqFrontEnd.setFFTOverlap((double)fftOverlap / 100.0);
+
+        fftReduce = core::configManager.conf["fftReduce"];
+        fftReduceMode = std::clamp<int>((int)core::configManager.conf["fftReduceMode"], 0, 1);
+        gui::waterfall.setReducedFFT(fftReduce, (dsp::fft::ReduceMode)fftReduceMode);
+        fftZoom = core::configManager.conf["fftZoom"];
+        sigpath::iqFrontEnd.setFFTZoom(fftZoom);
+
         gui::menu.locked = core::configManager.conf["lockMenuOrder"];
 
         fftHold = core::configManager.conf["fftHold"];
@@ -230,6 +248,53 @@ namespace displaymenu {
             core::configManager.release(true);
         }
 
+        ImGui::LeftLabel("FFT Averaging");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::InputInt("##sdrpp_fft_averages", &fftAverages, 1, 10)) {
+            fftAverages = std::max<int>(1, fftAverages);
+            sigpath::iqFrontEnd.setFFTAverages(fftAverages);
+            core::configManager.acquire();
+            core::configManager.conf["fftAverages"] = fftAverages;
+            core::configManager.release(true);
+        }
+
+        // The overlap only applies to averaged frames
+        ImGui::LeftLabel("FFT Overlap");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (fftAverages <= 1) { style::beginDisabled(); }
+        if (ImGui::SliderInt("##sdrpp_fft_overlap", &fftOverlap, 0, 95, "%d%%")) {
+            sigpath::iqFrontEnd.setFFTOverlap((double)fftOverlap / 100.0);
+            core::configManager.acquire();
+            core::configManager.conf["fftOverlap"] = fftOverlap;
+            core::configManager.release(true);
+        }
+        if (fftAverages <= 1) { style::endDisabled(); }
+
+        if (ImGui::Checkbox("Reduce FFT in DSP##_sdrpp", &fftReduce)) {
+            gui::waterfall.setReducedFFT(fftReduce, (dsp::fft::ReduceMode)fftReduceMode);
+            core::configManager.acquire();
+            core::configManager.conf["fftReduce"] = fftReduce;
+            core::configManager.release(true);
+        }
+
+        if (!fftReduce) { style::beginDisabled(); }
+        ImGui::LeftLabel("FFT Reduction");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        if (ImGui::Combo("##sdrpp_fft_reduce_mode", &fftReduceMode, "Max Hold\0Mean\0")) {
+            gui::waterfall.setReducedFFT(fftReduce, (dsp::fft::ReduceMode)fftReduceMode);
+            core::configManager.acquire();
+            core::configManager.conf["fftReduceMode"] = fftReduceMode;
+            core::configManager.release(true);
+        }
+
+        if (ImGui::Checkbox("Zoom FFT##_sdrpp", &fftZoom)) {
+            sigpath::iqFrontEnd.setFFTZoom(fftZoom);
+            core::configManager.acquire();
+            core::configManager.conf["fftZoom"] = fftZoom;
+            core::configManager.release(true);
+        }
+        if (!fftReduce) { style::endDisabled(); }
+
         if (colorMapNames.size() > 0) {
             ImGui::LeftLabel("Color Map");
             ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
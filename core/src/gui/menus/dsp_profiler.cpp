@@ -0,0 +1,119 @@
+#include <gui/menus/dsp_profiler.h>
+#include <imgui.h>
+#include <core.h>
+#include <gui/style.h>
+#include <dsp/perf.h>
+#include <map>
+
+namespace dsp_profiler_menu {
+    struct Row {
+        std::string name;
+        float cpu;
+        float mspsIn;
+        float mspsOut;
+        float waitPercent;
+        float fill;
+    };
+
+    std::map<const void*, dsp::perf::BlockStats> lastStats;
+    std::vector<Row> rows;
+    uint64_t lastUpdate = 0;
+    double bufferMemory = 0.0;
+    int logInterval = 0;
+
+    void update() {
+        uint64_t time = dsp::perf::now();
+        double elapsed = (double)(time - lastUpdate) * 1e-9;
+        lastUpdate = time;
+
+        std::map<const void*, dsp::perf::BlockStats> stats;
+        rows.clear();
+        for (auto& st : dsp::perf::getStats()) {
+            stats[st.id] = st;
+
+            // Blocks that just started have no rate yet
+            auto it = lastStats.find(st.id);
+            if (it == lastStats.end() || st.samplesIn < it->second.samplesIn || st.runTime < it->second.runTime) { continue; }
+            auto& last = it->second;
+
+            Row row;
+            row.name = st.name;
+            row.cpu = (st.processTime - last.processTime) * 100.0 / elapsed;
+            row.mspsIn = (double)(st.samplesIn - last.samplesIn) * 1e-6 / elapsed;
+            row.mspsOut = (double)(st.samplesOut - last.samplesOut) * 1e-6 / elapsed;
+            row.waitPercent = ((st.readWaitTime - last.readWaitTime) + (st.swapWaitTime - last.swapWaitTime)) * 100.0 / elapsed;
+            row.fill = st.fill * 100.0f;
+            rows.push_back(row);
+        }
+        lastStats = stats;
+        bufferMemory = (double)dsp::perf::getBufferMemory() / 1e6;
+
+        // Most expensive blocks first
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.cpu > b.cpu; });
+    }
+
+    void init() {
+        core::configManager.acquire();
+        logInterval = core::configManager.conf["dspProfilerLogInterval"];
+        core::configManager.release();
+    }
+
+    void draw(void* ctx) {
+        // Refresh once per second so that the numbers are readable
+        if (dsp::perf::now() - lastUpdate >= 1000000000ull) { update(); }
+
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (ImGui::BeginTable("DSP Profiler Table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY, ImVec2(0, 200.0f * style::uiScale))) {
+            ImGui::TableSetupColumn("Block");
+            ImGui::TableSetupColumn("CPU", ImGuiTableColumnFlags_WidthFixed, 50.0f * style::uiScale);
+            ImGui::TableSetupColumn("MS/s", ImGuiTableColumnFlags_WidthFixed, 50.0f * style::uiScale);
+            ImGui::TableSetupScrollFreeze(3, 1);
+            ImGui::TableHeadersRow();
+
+            for (auto& row : rows) {
+                ImGui::TableNextRow();
+
+                ImGui::TableSetColumnIndex(0);
+                ImGui::TextUnformatted(row.name.c_str());
+                if (ImGui::IsItemHovered()) {
+                    ImGui::BeginTooltip();
+                    ImGui::TextUnformatted(row.name.c_str());
+                    ImGui::Separator();
+                    ImGui::Text("Processing: %.2f%%", row.cpu);
+                    ImGui::Text("Waiting: %.2f%%", row.waitPercent);
+                    ImGui::Text("Input: %.3f MS/s", row.mspsIn);
+                    ImGui::Text("Output: %.3f MS/s", row.mspsOut);
+                    ImGui::Text("Max buffer fill: %.1f%%", row.fill);
+                    ImGui::EndTooltip();
+                }
+
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.1f%%", row.cpu);
+
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%.2f", row.mspsIn);
+            }
+
+            ImGui::EndTable();
+        }
+
+        ImGui::Text("Buffer memory: %.1f MB", bufferMemory);
+
+        if (ImGui::Button("Reset##dsp_profiler_reset", ImVec2(menuWidth, 0))) {
+            dsp::perf::resetStats();
+            lastStats.clear();
+            rows.clear();
+        }
+
+        ImGui::LeftLabel("Log interval (s)");
+        ImGui::FillWidth();
+        if (ImGui::InputInt("##dsp_profiler_log_interval", &logInterval)) {
+            logInterval = std::max<int>(logInterval, 0);
+            dsp::perf::setLogInterval(logInterval);
+            core::configManager.acquire();
+            core::configManager.conf["dspProfilerLogInterval"] = logInterval;
+            core::configManager.release(true);
+        }
+    }
+}
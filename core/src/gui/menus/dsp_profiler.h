@@ -0,0 +1,6 @@
+#pragma once
+
+namespace dsp_profiler_menu {
+    void init();
+    void draw(void* ctx);
+}
@@ -160,12 +160,9 @@ namespace sourcemenu {
 
         // Define decimation values
         decimations.define(1, "None", 1);
-        decimations.define(2, "2x", 2);
-        decimations.define(4, "4x", 4);
-        decimations.define(8, "8x", 8);
-        decimations.define(16, "16x", 16);
-        decimations.define(32, "32x", 32);
-        decimations.define(64, "64x", 64);
+        for (int ratio : { 2, 3, 4, 5, 6, 8, 10, 12, 16, 20, 24, 32, 40, 48, 64 }) {
+            decimations.define(ratio, std::to_string(ratio) + "x", ratio);
+        }
 
         // Acquire the config file
         core::configManager.acquire();
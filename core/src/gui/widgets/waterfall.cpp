@@ -4,6 +4,7 @@
 #include <imutils.h>
 #include <algorithm>
 #include <volk/volk.h>
+#include <dsp/kernels/kernels.h>
 #include <utils/flog.h>
 #include <gui/gui.h>
 #include <gui/style.h>
@@ -64,9 +65,6 @@ inline void printAndScale(double freq, char* buf) {
 
 inline void doZoom(int offset, int width, int inSize, int outSize, float* in, float* out) {
     // NOTE: REMOVE THAT SHIT, IT'S JUST A HACKY FIX
-    if (offset < 0) {
-        offset = 0;
-    }
     if (width > 524288) {
         width = 524288;
     }
@@ -79,7 +77,15 @@ inline void doZoom(int offset, int width, int inSize, int outSize, float* in, fl
     int sId;
     for (int i = 0; i < outSize; i++) {
         maxVal = -INFINITY;
-        sId = (int)id;
+        sId = (int)floorf(id);
+
+        // Reduced lines may only cover part of the view
+        if (sId < 0 || sId >= inSize) {
+            out[i] = maxVal;
+            id += factor;
+            continue;
+        }
+
         uFactor = (sId + sFactor > inSize) ? sFactor - ((sId + sFactor) - inSize) : sFactor;
         for (int j = 0; j < uFactor; j++) {
             if (in[sId + j] > maxVal) { maxVal = in[sId + j]; }
@@ -557,16 +563,24 @@ namespace ImGui {
 
     bool WaterFall::calculateVFOSignalInfo(float* fftLine, WaterfallVFO* _vfo, float& strength, float& snr) {
         if (fftLine == NULL || fftLines <= 0) { return false; }
+        double lineStart, lineWidth;
+        int lineSize;
+        fftLine = getLineData(fftLine, lineStart, lineWidth, lineSize);
+        if (lineSize <= 0) { return false; }
 
         // Calculate FFT index data
         double vfoMinSizeFreq = _vfo->centerOffset - _vfo->bandwidth;
         double vfoMinFreq = _vfo->centerOffset - (_vfo->bandwidth / 2.0);
         double vfoMaxFreq = _vfo->centerOffset + (_vfo->bandwidth / 2.0);
         double vfoMaxSizeFreq = _vfo->centerOffset + _vfo->bandwidth;
-        int vfoMinSideOffset = std::clamp<int>(((vfoMinSizeFreq / (wholeBandwidth / 2.0)) * (double)(rawFFTSize / 2)) + (rawFFTSize / 2), 0, rawFFTSize);
-        int vfoMinOffset = std::clamp<int>(((vfoMinFreq / (wholeBandwidth / 2.0)) * (double)(rawFFTSize / 2)) + (rawFFTSize / 2), 0, rawFFTSize);
-        int vfoMaxOffset = std::clamp<int>(((vfoMaxFreq / (wholeBandwidth / 2.0)) * (double)(rawFFTSize / 2)) + (rawFFTSize / 2), 0, rawFFTSize);
-        int vfoMaxSideOffset = std::clamp<int>(((vfoMaxSizeFreq / (wholeBandwidth / 2.0)) * (double)(rawFFTSize / 2)) + (rawFFTSize / 2), 0, rawFFTSize);
+        auto freqToIndex = [=](double freq) {
+            double pos = ((freq / wholeBandwidth) + 0.5 - lineStart) / lineWidth;
+            return std::clamp<int>(pos * (double)lineSize, 0, lineSize);
+        };
+        int vfoMinSideOffset = freqToIndex(vfoMinSizeFreq);
+        int vfoMinOffset = freqToIndex(vfoMinFreq);
+        int vfoMaxOffset = freqToIndex(vfoMaxFreq);
+        int vfoMaxSideOffset = freqToIndex(vfoMaxSizeFreq);
 
         double avg = 0;
         float max = -INFINITY;
@@ -597,27 +611,41 @@ namespace ImGui {
         return true;
     }
 
+    float* WaterFall::getLineData(float* line, double& start, double& width, int& size) {
+        if (!reducedFFT) {
+            start = 0.0;
+            width = 1.0;
+            size = rawFFTSize;
+            return line;
+        }
+        size = line[0];
+        start = line[1];
+        width = line[2];
+        return &line[WATERFALL_REDUCED_HEADER];
+    }
+
+    void WaterFall::zoomLine(float* line, float* out) {
+        double start, width;
+        int size;
+        float* data = getLineData(line, start, width, size);
+        double viewStart = 0.5 + ((viewOffset - (viewBandwidth / 2.0)) / wholeBandwidth);
+        double viewWidth = viewBandwidth / wholeBandwidth;
+        int drawDataStart = ((viewStart - start) / width) * (double)size;
+        int drawDataSize = (viewWidth / width) * (double)size;
+        doZoom(drawDataStart, drawDataSize, size, dataWidth, data, out);
+    }
+
     void WaterFall::updateWaterfallFb() {
         if (!waterfallVisible || rawFFTs == NULL) {
             return;
         }
-        double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
-        int drawDataSize;
-        int drawDataStart;
         // TODO: Maybe put on the stack for faster alloc?
         float* tempData = new float[dataWidth];
-        float pixel;
-        float dataRange = waterfallMax - waterfallMin;
         int count = std::min<float>(waterfallHeight, fftLines);
         if (rawFFTs != NULL && fftLines >= 0) {
             for (int i = 0; i < count; i++) {
-                drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
-                drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
-                doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[((i + currentFFTLine) % waterfallHeight) * rawFFTSize], tempData);
-                for (int j = 0; j < dataWidth; j++) {
-                    pixel = (std::clamp<float>(tempData[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
-                    waterfallFb[(i * dataWidth) + j] = waterfallPallet[(int)(pixel * (WATERFALL_RESOLUTION - 1))];
-                }
+                zoomLine(&rawFFTs[((i + currentFFTLine) % waterfallHeight) * rawFFTSize], tempData);
+                dsp::kernels::get().paletteMap(&waterfallFb[i * dataWidth], tempData, dataWidth, waterfallMin, waterfallMax, waterfallPallet, WATERFALL_RESOLUTION);
             }
 
             for (int i = count; i < waterfallHeight; i++) {
@@ -873,40 +901,49 @@ namespace ImGui {
         buf_mtx.unlock();
     }
 
-    float* WaterFall::getFFTBuffer() {
+    float* WaterFall::getFFTBuffer(const dsp::fft::SpectrumView& view) {
         if (rawFFTs == NULL) { return NULL; }
         buf_mtx.lock();
+
+        // Spectra computed before switching between whole and reduced spectra don't fit the lines
+        if ((view.pixels > 0) != reducedFFT) {
+            buf_mtx.unlock();
+            return NULL;
+        }
+        lineAcquired = true;
+
+        float* line = rawFFTs;
         if (waterfallVisible) {
             currentFFTLine--;
             fftLines++;
             currentFFTLine = ((currentFFTLine + waterfallHeight) % waterfallHeight);
             fftLines = std::min<float>(fftLines, waterfallHeight);
-            return &rawFFTs[currentFFTLine * rawFFTSize];
+            line = &rawFFTs[currentFFTLine * rawFFTSize];
         }
-        return rawFFTs;
+        return reducedFFT ? &line[WATERFALL_REDUCED_HEADER] : line;
     }
 
-    void WaterFall::pushFFT() {
-        if (rawFFTs == NULL) { return; }
+    void WaterFall::pushFFT(const dsp::fft::SpectrumView& view) {
+        if (!lineAcquired) { return; }
+        lineAcquired = false;
         std::lock_guard<std::recursive_mutex> lck(latestFFTMtx);
-        double offsetRatio = viewOffset / (wholeBandwidth / 2.0);
-        int drawDataSize = (viewBandwidth / wholeBandwidth) * rawFFTSize;
-        int drawDataStart = (((double)rawFFTSize / 2.0) * (offsetRatio + 1)) - (drawDataSize / 2);
+
+        // Remember what part of the spectrum a reduced line covers so that it can be zoomed again later
+        float* line = waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs;
+        if (reducedFFT) {
+            line[0] = view.pixels;
+            line[1] = view.start;
+            line[2] = view.width;
+        }
 
         if (waterfallVisible) {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, &rawFFTs[currentFFTLine * rawFFTSize], latestFFT);
+            zoomLine(line, latestFFT);
             memmove(&waterfallFb[dataWidth], waterfallFb, dataWidth * (waterfallHeight - 1) * sizeof(uint32_t));
-            float pixel;
-            float dataRange = waterfallMax - waterfallMin;
-            for (int j = 0; j < dataWidth; j++) {
-                pixel = (std::clamp<float>(latestFFT[j], waterfallMin, waterfallMax) - waterfallMin) / dataRange;
-                int id = (int)(pixel * (WATERFALL_RESOLUTION - 1));
-                waterfallFb[j] = waterfallPallet[id];
-            }
+            dsp::kernels::get().paletteMap(waterfallFb, latestFFT, dataWidth, waterfallMin, waterfallMax, waterfallPallet, WATERFALL_RESOLUTION);
             waterfallUpdate = true;
         }
         else {
-            doZoom(drawDataStart, drawDataSize, rawFFTSize, dataWidth, rawFFTs, latestFFT);
+            zoomLine(line, latestFFT);
             fftLines = 1;
         }
 
@@ -923,11 +960,11 @@ namespace ImGui {
             float dummy;
             if (snrSmoothing) {
                 float newSNR = 0.0f;
-                calculateVFOSignalInfo(waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs, vfos[selectedVFO], dummy, newSNR);
+                calculateVFOSignalInfo(line, vfos[selectedVFO], dummy, newSNR);
                 selectedVFOSNR = (snrSmoothingBeta*selectedVFOSNR) + (snrSmoothingAlpha*newSNR);
             }
             else {
-                calculateVFOSignalInfo(waterfallVisible ? &rawFFTs[currentFFTLine * rawFFTSize] : rawFFTs, vfos[selectedVFO], dummy, selectedVFOSNR);
+                calculateVFOSignalInfo(line, vfos[selectedVFO], dummy, selectedVFOSNR);
             }
         }
 
@@ -1133,7 +1170,8 @@ namespace ImGui {
 
     void WaterFall::setRawFFTSize(int size) {
         std::lock_guard<std::recursive_mutex> lck(buf_mtx);
-        rawFFTSize = size;
+        fullFFTSize = size;
+        rawFFTSize = reducedFFT ? (WATERFALL_REDUCED_HEADER + SPECTRUM_PIPELINE_MAX_PIXELS) : fullFFTSize;
         int wfSize = std::max<int>(1, waterfallHeight);
         if (rawFFTs != NULL) {
             rawFFTs = (float*)realloc(rawFFTs, rawFFTSize * wfSize * sizeof(float));
@@ -1146,6 +1184,30 @@ namespace ImGui {
         updateWaterfallFb();
     }
 
+    void WaterFall::setReducedFFT(bool enabled, dsp::fft::ReduceMode mode) {
+        std::lock_guard<std::recursive_mutex> lck(buf_mtx);
+        reduceMode = mode;
+        if (enabled == reducedFFT) { return; }
+        reducedFFT = enabled;
+
+        // The stored lines change format, so they're cleared
+        setRawFFTSize(fullFFTSize);
+    }
+
+    bool WaterFall::isReducedFFT() {
+        return reducedFFT;
+    }
+
+    dsp::fft::SpectrumView WaterFall::getFFTView() {
+        dsp::fft::SpectrumView view;
+        if (!reducedFFT) { return view; }
+        view.pixels = dataWidth;
+        view.start = 0.5 + ((viewOffset - (viewBandwidth / 2.0)) / wholeBandwidth);
+        view.width = viewBandwidth / wholeBandwidth;
+        view.mode = reduceMode;
+        return view;
+    }
+
     void WaterFall::setBandPlanPos(int pos) {
         bandPlanPos = pos;
     }
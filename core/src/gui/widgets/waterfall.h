@@ -5,11 +5,15 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 #include <utils/event.h>
+#include <dsp/fft/spectrum_pipeline.h>
 
 #include <utils/opengl_include_code.h>
 
 #define WATERFALL_RESOLUTION 1000000
 
+// Values at the start of stored reduced lines: pixel count, start and width of the part of the spectrum they cover
+#define WATERFALL_REDUCED_HEADER 4
+
 namespace ImGui {
     class WaterfallVFO {
     public:
@@ -87,8 +91,8 @@ namespace ImGui {
         void init();
 
         void draw();
-        float* getFFTBuffer();
-        void pushFFT();
+        float* getFFTBuffer(const dsp::fft::SpectrumView& view = dsp::fft::SpectrumView());
+        void pushFFT(const dsp::fft::SpectrumView& view = dsp::fft::SpectrumView());
 
         void updatePallette(float colors[][3], int colorCount);
         void updatePalletteFromArray(float* colors, int colorCount);
@@ -135,6 +139,13 @@ namespace ImGui {
 
         void setRawFFTSize(int size);
 
+        // Take spectra already reduced to the part on screen instead of whole FFTs. Lines in the other format are dropped.
+        void setReducedFFT(bool enabled, dsp::fft::ReduceMode mode = dsp::fft::REDUCE_MAX);
+        bool isReducedFFT();
+
+        // Part of the spectrum the front end should hand over, zero pixels for the whole FFT
+        dsp::fft::SpectrumView getFFTView();
+
         void setFullWaterfallUpdate(bool fullUpdate);
 
         void setBandPlanPos(int pos);
@@ -230,6 +241,8 @@ namespace ImGui {
         void updateWaterfallTexture();
         void updateAllVFOs(bool checkRedrawRequired = false);
         bool calculateVFOSignalInfo(float* fftLine, WaterfallVFO* vfo, float& strength, float& snr);
+        float* getLineData(float* line, double& start, double& width, int& size);
+        void zoomLine(float* line, float* out);
 
         bool waterfallUpdate = false;
 
@@ -283,6 +296,10 @@ namespace ImGui {
 
         //std::vector<std::vector<float>> rawFFTs;
         int rawFFTSize;
+        int fullFFTSize = 0;
+        bool reducedFFT = false;
+        dsp::fft::ReduceMode reduceMode = dsp::fft::REDUCE_MAX;
+        bool lineAcquired = false;
         float* rawFFTs = NULL;
         float* latestFFT = NULL;
         float* latestFFTHold = NULL;
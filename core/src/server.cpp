@@ -14,7 +14,9 @@
 
 namespace server {
     dsp::stream<dsp::complex_t> dummyInput;
-    dsp::compression::SampleStreamCompressor comp;
+    dsp::stream<dsp::complex16_t> dummyInput16;
+    dsp::compression::SampleStreamCompressor<> comp;
+    dsp::compression::SampleStreamCompressor<dsp::complex16_t> comp16;
     dsp::sink::Handler<uint8_t> hnd;
     net::Conn client;
     uint8_t* rbuf = NULL;
@@ -51,11 +53,13 @@ namespace server {
 
         // Init DSP
         comp.init(&dummyInput, dsp::compression::PCM_TYPE_I8);
+        comp16.init(&dummyInput16, dsp::compression::PCM_TYPE_I8);
         hnd.init(&comp.out, _testServerHandler, NULL);
         rbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
         sbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
         bbuf = new uint8_t[SERVER_MAX_PACKET_SIZE];
         comp.start();
+        comp16.start();
         hnd.start();
 
         // Initialize headers
@@ -191,6 +195,7 @@ namespace server {
         // Perform settings reset
         sigpath::sourceManager.stop();
         comp.setPCMType(dsp::compression::PCM_TYPE_I16);
+        comp16.setPCMType(dsp::compression::PCM_TYPE_I16);
         compression = false;
 
         sendSampleRate(sampleRate);
@@ -243,7 +248,15 @@ namespace server {
     }
 
     void setInput(dsp::stream<dsp::complex_t>* stream) {
+        comp16.setInput(&dummyInput16);
         comp.setInput(stream);
+        hnd.setInput(&comp.out);
+    }
+
+    void setInput(dsp::stream<dsp::complex16_t>* stream) {
+        comp.setInput(&dummyInput);
+        comp16.setInput(stream);
+        hnd.setInput(&comp16.out);
     }
 
     void commandHandler(Command cmd, uint8_t* data, int len) {
@@ -294,6 +307,7 @@ namespace server {
         else if (cmd == COMMAND_SET_SAMPLE_TYPE && len == 1) {
             dsp::compression::PCMType type = (dsp::compression::PCMType)*(uint8_t*)data;
             comp.setPCMType(type);
+            comp16.setPCMType(type);
         }
         else if (cmd == COMMAND_SET_COMPRESSION && len == 1) {
             compression = *(uint8_t*)data;
@@ -6,6 +6,7 @@
 
 namespace server {
     void setInput(dsp::stream<dsp::complex_t>* stream);
+    void setInput(dsp::stream<dsp::complex16_t>* stream);
     int main();
 
     void _clientHandler(net::Conn conn, void* ctx);
@@ -8,10 +8,6 @@
 IQFrontEnd::~IQFrontEnd() {
     if (!_init) { return; }
     stop();
-    dsp::buffer::free(fftWindowBuf);
-    fftwf_destroy_plan(fftwPlan);
-    fftwf_free(fftInBuf);
-    fftwf_free(fftOutBuf);
 }
 
 void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx) {
@@ -28,6 +24,9 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
 
     inBuf.init(in);
     inBuf.bypass = !buffering;
+    inBuf16.init(&nullIn16);
+    inBuf16.bypass = !buffering;
+    decim16.init(&inBuf16.out, _decimRatio);
 
     decim.init(NULL, _decimRatio);
     dcBlock.init(NULL, genDCBlockRate(effectiveSr));
@@ -37,32 +36,39 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     preproc.addBlock(&decim, _decimRatio > 1);
     preproc.addBlock(&dcBlock, dcBlocking);
     preproc.addBlock(&conjugate, false); // TODO: Replace by parameter
+    preproc.setFused(true, [](dsp::stream<dsp::complex_t>* out){});
 
     split.init(preproc.out);
+    split.setZeroCopy(true);
 
     // TODO: Do something to avoid basically repeating this code twice
-    int skip;
-    genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, _nzFFTSize);
+    int skip, averages;
+    genReshapeParams(effectiveSr, _fftSize, _fftRate, _fftAverages, _fftOverlap, skip, _nzFFTSize, averages);
     reshape.init(&fftIn, fftSize, skip);
     fftSink.init(&reshape.out, handler, this);
+    fftPipeline.init(fftThreads, acquireFFTBuffer, releaseFFTBuffer, this);
+
+    // Zoom FFT, retuned and given its parameters once zoomed in
+    zoomVFO.init(&zoomIn, effectiveSr, effectiveSr / 2.0, effectiveSr / 2.0, 0.0);
+    zoomReshape.init(&zoomVFO.out, fftSize, 0);
+    zoomSink.init(&zoomReshape.out, zoomHandler, this);
+    zoomPipeline.init(fftThreads, acquireZoomBuffer, releaseZoomBuffer, this);
+
+    channelizer.init(&chanIn, genChannelCount(effectiveSr), effectiveSr);
+
+    // Names shown by the DSP profiler
+    inBuf.setPerfName("IQ Buffer");
+    inBuf16.setPerfName("IQ Buffer (16 bit)");
+    decim16.setPerfName("IQ Decimator (16 bit)");
+    split.setPerfName("IQ Splitter");
+    reshape.setPerfName("FFT Reshaper");
+    fftSink.setPerfName("FFT");
+    zoomVFO.setPerfName("Zoom FFT VFO");
+    zoomReshape.setPerfName("Zoom FFT Reshaper");
+    zoomSink.setPerfName("Zoom FFT");
+    channelizer.setPerfName("VFO Channelizer");
 
-    fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
-    if (_fftWindow == FFTWindow::RECTANGULAR) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 0; }
-    }
-    else if (_fftWindow == FFTWindow::BLACKMAN) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize); }
-    }
-    else if (_fftWindow == FFTWindow::NUTTALL) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize); }
-    }
-
-    fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
-
-    // Clear the rest of the FFT input buffer
-    dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
+    updateFFTPath();
 
     split.bindStream(&fftIn);
 
@@ -71,11 +77,32 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
 
 void IQFrontEnd::setInput(dsp::stream<dsp::complex_t>* in) {
     inBuf.setInput(in);
+    if (!int16Input) { return; }
+
+    // Go back to decimating in the pre-processing chain
+    int16Input = false;
+    inBuf16.setInput(&nullIn16);
+    preproc.setInput(&inBuf.out, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    preproc.setBlockEnabled(&decim, _decimRatio > 1, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+}
+
+void IQFrontEnd::setInput(dsp::stream<dsp::complex16_t>* in) {
+    inBuf16.setInput(in);
+    if (int16Input) { return; }
+
+    // The 16 bit decimator takes over the decimation and feeds the pre-processing chain
+    int16Input = true;
+    inBuf.setInput(&nullIn);
+    preproc.setBlockEnabled(&decim, false, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    preproc.setInput(&decim16.out, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 }
 
 void IQFrontEnd::setSampleRate(double sampleRate) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+
     // Temp stop the necessary blocks
     dcBlock.tempStop();
+    channelizer.tempStop();
     for (auto& [name, vfo] : vfos) {
         vfo->tempStop();
     }
@@ -84,8 +111,14 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
     _sampleRate = sampleRate;
     effectiveSr = _sampleRate / _decimRatio;
     dcBlock.setRate(genDCBlockRate(effectiveSr));
+    channelizer.setChannels(genChannelCount(effectiveSr), effectiveSr);
     for (auto& [name, vfo] : vfos) {
-        vfo->setInSamplerate(effectiveSr);
+        if (vfoChannelized[name]) {
+            vfo->setPretunedInput(true, channelizer.getChannelRate());
+        }
+        else {
+            vfo->setInSamplerate(effectiveSr);
+        }
     }
 
     // Reconfigure the FFT
@@ -93,13 +126,18 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
 
     // Restart blocks
     dcBlock.tempStart();
+    channelizer.tempStart();
     for (auto& [name, vfo] : vfos) {
         vfo->tempStart();
     }
+
+    // The channels may now be too narrow for some VFOs
+    updateChannelization();
 }
 
 void IQFrontEnd::setBuffering(bool enabled) {
     inBuf.bypass = !enabled;
+    inBuf16.bypass = !enabled;
 }
 
 void IQFrontEnd::setDecimation(int ratio) {
@@ -109,13 +147,14 @@ void IQFrontEnd::setDecimation(int ratio) {
     // Update the decimation ratio
     _decimRatio = ratio;
     if (_decimRatio > 1) { decim.setRatio(_decimRatio); }
+    decim16.setRatio(_decimRatio);
     setSampleRate(_sampleRate);
 
     // Restart the decimator if it was running
     decim.tempStart();
 
-    // Enable or disable in the chain
-    preproc.setBlockEnabled(&decim, _decimRatio > 1, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
+    // Enable or disable in the chain, the 16 bit decimator does it instead when in use
+    preproc.setBlockEnabled(&decim, !int16Input && _decimRatio > 1, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 
     // Update the DSP sample rate (TODO: Find a way to get rid of this)
     core::setInputSampleRate(_sampleRate);
@@ -138,6 +177,8 @@ void IQFrontEnd::unbindIQStream(dsp::stream<dsp::complex_t>* stream) {
 }
 
 dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, double bandwidth, double offset) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+
     // Make sure no other VFO with that name already exists
     if (vfos.find(name) != vfos.end()) {
         flog::error("[IQFrontEnd] Tried to add VFO with existing name.");
@@ -147,19 +188,27 @@ dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, dou
     // Create VFO and its input stream
     dsp::stream<dsp::complex_t>* vfoIn = new dsp::stream<dsp::complex_t>;
     dsp::channel::RxVFO* vfo = new dsp::channel::RxVFO(vfoIn, effectiveSr, sampleRate, bandwidth, offset);
+    vfo->setPerfName("VFO " + name);
+    vfo->setRetuneHandler(vfoRetuned, this);
 
     // Register them
     vfoStreams[name] = vfoIn;
     vfos[name] = vfo;
+    vfoChannelized[name] = false;
     bindIQStream(vfoIn);
 
     // Start VFO
     vfo->start();
 
+    // Move it to the channelizer if it's one narrow VFO too many
+    updateChannelization();
+
     return vfo;
 }
 
 void IQFrontEnd::removeVFO(std::string name) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+
     // Make sure that a VFO with that name exists
     if (vfos.find(name) == vfos.end()) {
         flog::error("[IQFrontEnd] Tried to remove a VFO that doesn't exist.");
@@ -173,13 +222,30 @@ void IQFrontEnd::removeVFO(std::string name) {
     // Stop the VFO
     vfo->stop();
 
-    unbindIQStream(vfoIn);
+    // Unbind its input from wherever it comes from
+    if (vfoChannelized[name]) {
+        channelizer.unbindStream(vfoIn);
+        if (!--channelizedCount) { unbindIQStream(&chanIn); }
+    }
+    else {
+        unbindIQStream(vfoIn);
+    }
     vfoStreams.erase(name);
     vfos.erase(name);
+    vfoChannelized.erase(name);
 
     // Delete the VFO and its input stream
     delete vfo;
     delete vfoIn;
+
+    // The remaining narrow VFOs may no longer be worth channelizing
+    updateChannelization();
+}
+
+void IQFrontEnd::setChannelizerMinVFOs(int count) {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
+    channelizerMinVFOs = count;
+    updateChannelization();
 }
 
 void IQFrontEnd::setFFTSize(int size) {
@@ -197,13 +263,54 @@ void IQFrontEnd::setFFTWindow(FFTWindow fftWindow) {
     updateFFTPath();
 }
 
+void IQFrontEnd::setFFTAverages(int averages) {
+    _fftAverages = std::max<int>(averages, 1);
+    updateFFTPath();
+}
+
+void IQFrontEnd::setFFTOverlap(double overlap) {
+    _fftOverlap = std::clamp<double>(overlap, 0.0, 0.95);
+    updateFFTPath();
+}
+
+void IQFrontEnd::setFFTThreads(int threads) {
+    fftThreads = threads;
+    if (!_init) { return; }
+    fftSink.tempStop();
+    zoomSink.tempStop();
+    fftPipeline.setThreads(fftThreads);
+    zoomPipeline.setThreads(fftThreads);
+    zoomSink.tempStart();
+    fftSink.tempStart();
+}
+
+void IQFrontEnd::setFFTView(const dsp::fft::SpectrumView& view) {
+    std::lock_guard<std::recursive_mutex> lck(zoomMtx);
+    fftView = view;
+    fftPipeline.setView(view);
+    updateZoom();
+}
+
+const dsp::fft::SpectrumView& IQFrontEnd::getDeliveredFFTView() {
+    return deliveredView;
+}
+
+void IQFrontEnd::setFFTZoom(bool enabled) {
+    std::lock_guard<std::recursive_mutex> lck(zoomMtx);
+    zoomEnabled = enabled;
+    if (_init) { updateZoom(); }
+}
+
 void IQFrontEnd::flushInputBuffer() {
     inBuf.flush();
+    inBuf16.flush();
 }
 
 void IQFrontEnd::start() {
-    // Start input buffer
+    // Start input buffers and the 16 bit decimator
     inBuf.start();
+    inBuf16.start();
+    decim16.start();
 
     // Start pre-proc chain (automatically start all bound blocks)
     preproc.start();
@@ -211,7 +318,8 @@ void IQFrontEnd::start() {
     // Start IQ splitter
     split.start();
 
-    // Start all VFOs
+    // Start the channelizer and all VFOs
+    channelizer.start();
     for (auto& [name, vfo] : vfos) {
         vfo->start();
     }
@@ -219,11 +327,18 @@ void IQFrontEnd::start() {
     // Start FFT chain
     reshape.start();
     fftSink.start();
+
+    // Start zoom FFT chain
+    zoomVFO.start();
+    zoomReshape.start();
+    zoomSink.start();
 }
 
 void IQFrontEnd::stop() {
-    // Stop input buffer
+    // Stop input buffers and the 16 bit decimator
     inBuf.stop();
+    inBuf16.stop();
+    decim16.stop();
 
     // Stop pre-proc chain (automatically start all bound blocks)
     preproc.stop();
@@ -231,7 +346,8 @@ void IQFrontEnd::stop() {
     // Stop IQ splitter
     split.stop();
 
-    // Stop all VFOs
+    // Stop the channelizer and all VFOs
+    channelizer.stop();
     for (auto& [name, vfo] : vfos) {
         vfo->stop();
     }
@@ -239,31 +355,109 @@ void IQFrontEnd::stop() {
     // Stop FFT chain
     reshape.stop();
     fftSink.stop();
+
+    // Stop zoom FFT chain
+    zoomVFO.stop();
+    zoomReshape.stop();
+    zoomSink.stop();
 }
 
 double IQFrontEnd::getEffectiveSamplerate() {
     return effectiveSr;
 }
 
-void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
+void IQFrontEnd::vfoRetuned(dsp::channel::RxVFO* vfo, void* ctx) {
     IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    _this->updateChannelization();
+}
 
-    // Apply window
-    volk_32fc_32f_multiply_32fc((lv_32fc_t*)_this->fftInBuf, (lv_32fc_t*)data, _this->fftWindowBuf, _this->_nzFFTSize);
+void IQFrontEnd::updateChannelization() {
+    std::lock_guard<std::recursive_mutex> lck(vfoMtx);
 
-    // Execute FFT
-    fftwf_execute(_this->fftwPlan);
+    // Only narrow VFOs fit in a channel, and the channelizer only pays off once enough of them share it
+    double maxBandwidth = channelizer.getMaxBandwidth();
+    int narrowCount = 0;
+    for (auto& [name, vfo] : vfos) {
+        if (vfo->getBandwidth() <= maxBandwidth) { narrowCount++; }
+    }
+    bool enabled = (channelizerMinVFOs > 0 && channelizer.getChannels() >= 4 && narrowCount >= channelizerMinVFOs);
 
-    // Aquire buffer
-    float* fftBuf = _this->_acquireFFTBuffer(_this->_fftCtx);
+    for (auto& [name, vfo] : vfos) {
+        bool channelized = (enabled && vfo->getBandwidth() <= maxBandwidth);
+        if (channelized != vfoChannelized[name]) {
+            setChannelized(name, channelized);
+        }
+        else if (channelized) {
+            channelizer.setOffset(vfoStreams[name], vfo->getOffset());
+        }
+    }
+}
 
-    // Convert the complex output of the FFT to dB amplitude
-    if (fftBuf) {
-        volk_32fc_s32f_power_spectrum_32f(fftBuf, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
+void IQFrontEnd::setChannelized(const std::string& name, bool channelized) {
+    dsp::stream<dsp::complex_t>* vfoIn = vfoStreams[name];
+    dsp::channel::RxVFO* vfo = vfos[name];
+
+    // The VFO is stopped while its input changes source and samplerate
+    vfo->tempStop();
+    if (channelized) {
+        if (!channelizedCount++) { bindIQStream(&chanIn); }
+        unbindIQStream(vfoIn);
+        channelizer.bindStream(vfoIn, vfo->getOffset());
+        vfo->setPretunedInput(true, channelizer.getChannelRate());
+    }
+    else {
+        channelizer.unbindStream(vfoIn);
+        if (!--channelizedCount) { unbindIQStream(&chanIn); }
+        bindIQStream(vfoIn);
+        vfo->setPretunedInput(false, effectiveSr);
     }
+    vfo->tempStart();
+    vfoChannelized[name] = channelized;
+
+    flog::info("[IQFrontEnd] VFO '{0}' {1} the channelizer", name, channelized ? "moved to" : "moved off");
+}
+
+void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
+
+    // The pipeline windows the frame and leaves the FFT and dB conversion to its workers
+    _this->fftPipeline.push(data, count);
+}
+
+void IQFrontEnd::zoomHandler(dsp::complex_t* data, int count, void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    _this->zoomPipeline.push(data, count);
+}
+
+float* IQFrontEnd::acquireFFTBuffer(void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    _this->deliverMtx.lock();
+    _this->deliveredView = _this->fftPipeline.getDeliveredView();
+    return _this->_acquireFFTBuffer(_this->_fftCtx);
+}
 
-    // Release buffer
+void IQFrontEnd::releaseFFTBuffer(void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
     _this->_releaseFFTBuffer(_this->_fftCtx);
+    _this->deliverMtx.unlock();
+}
+
+float* IQFrontEnd::acquireZoomBuffer(void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    _this->deliverMtx.lock();
+
+    // Map the view back from the zoom band to the whole spectrum
+    dsp::fft::SpectrumView view = _this->zoomPipeline.getDeliveredView();
+    view.start = _this->zoomStart + (view.start / (double)_this->zoomRatio);
+    view.width = view.width / (double)_this->zoomRatio;
+    _this->deliveredView = view;
+    return _this->_acquireFFTBuffer(_this->_fftCtx);
+}
+
+void IQFrontEnd::releaseZoomBuffer(void* ctx) {
+    IQFrontEnd* _this = (IQFrontEnd*)ctx;
+    _this->_releaseFFTBuffer(_this->_fftCtx);
+    _this->deliverMtx.unlock();
 }
 
 void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
@@ -272,38 +466,116 @@ void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
     fftSink.tempStop();
 
     // Update reshaper settings
-    int skip;
-    genReshapeParams(effectiveSr, _fftSize, _fftRate, skip, _nzFFTSize);
+    int skip, averages;
+    genReshapeParams(effectiveSr, _fftSize, _fftRate, _fftAverages, _fftOverlap, skip, _nzFFTSize, averages);
     reshape.setKeep(_nzFFTSize);
     reshape.setSkip(skip);
 
     // Update window
-    dsp::buffer::free(fftWindowBuf);
-    fftWindowBuf = dsp::buffer::alloc<float>(_nzFFTSize);
+    std::vector<float> fftWindowBuf(_nzFFTSize);
+    genFFTWindow(fftWindowBuf.data(), _nzFFTSize);
+
+    // Update FFT buffers and plan, once the frames still in the pipeline are done
+    fftPipeline.setParams(_fftSize, fftWindowBuf.data(), _nzFFTSize, averages);
+
+    // Update waterfall (TODO: This is annoying, it makes this module non testable and will constantly clear the waterfall for any reason)
+    if (updateWaterfall) { gui::waterfall.setRawFFTSize(_fftSize); }
+
+    // Restart branch
+    reshape.tempStart();
+    fftSink.tempStart();
+
+    // The zoom FFT follows the same parameters
+    updateZoom(true);
+}
+
+void IQFrontEnd::genFFTWindow(float* buf, int size) {
+    // Alternating the sign moves DC to the middle of the spectrum
     if (_fftWindow == FFTWindow::RECTANGULAR) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = 1.0f * ((i % 2) ? -1.0f : 1.0f); }
+        for (int i = 0; i < size; i++) { buf[i] = 1.0f * ((i % 2) ? -1.0f : 1.0f); }
     }
     else if (_fftWindow == FFTWindow::BLACKMAN) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::blackman(i, _nzFFTSize) * ((i % 2) ? -1.0f : 1.0f); }
+        for (int i = 0; i < size; i++) { buf[i] = dsp::window::blackman(i, size) * ((i % 2) ? -1.0f : 1.0f); }
     }
     else if (_fftWindow == FFTWindow::NUTTALL) {
-        for (int i = 0; i < _nzFFTSize; i++) { fftWindowBuf[i] = dsp::window::nuttall(i, _nzFFTSize) * ((i % 2) ? -1.0f : 1.0f); }
+        for (int i = 0; i < size; i++) { buf[i] = dsp::window::nuttall(i, size) * ((i % 2) ? -1.0f : 1.0f); }
     }
+}
 
-    // Update FFT plan
-    fftwf_free(fftInBuf);
-    fftwf_free(fftOutBuf);
-    fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
-    fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+void IQFrontEnd::updateZoom(bool retune) {
+    std::lock_guard<std::recursive_mutex> lck(zoomMtx);
 
-    // Clear the rest of the FFT input buffer
-    dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
+    // Go back to the FFT of the whole band once it resolves the view
+    int ratio = zoomEnabled ? genZoomRatio(fftView, _fftSize, effectiveSr) : 1;
+    if (ratio == 1) {
+        setZoomed(false);
+        return;
+    }
 
-    // Update waterfall (TODO: This is annoying, it makes this module non testable and will constantly clear the waterfall for any reason)
-    if (updateWaterfall) { gui::waterfall.setRawFFTSize(_fftSize); }
+    // Only retune when the zoom level changes or the view gets close to the edges of the band, panning within it
+    // just moves the part of the zoom spectrum that is handed over
+    double width = 1.0 / (double)ratio;
+    double margin = width * IQFRONTEND_ZOOM_MARGIN;
+    bool inBand = (fftView.start >= zoomStart + margin && fftView.start + fftView.width <= zoomStart + width - margin);
+    if (retune || !zoomed || ratio != zoomRatio || !inBand) {
+        updateZoomPath(ratio, fftView.start + (fftView.width / 2.0) - (width / 2.0));
+    }
+    else {
+        zoomPipeline.setView(genZoomView());
+    }
+    setZoomed(true);
+}
+
+void IQFrontEnd::updateZoomPath(int ratio, double start) {
+    // Temp stop the zoom branch and let the spectra of the old band through first
+    zoomVFO.tempStop();
+    zoomReshape.tempStop();
+    zoomSink.tempStop();
+    zoomPipeline.flush();
+
+    // Translate the middle of the band to DC and decimate it
+    zoomRatio = ratio;
+    zoomStart = start;
+    double zoomSr = effectiveSr / (double)zoomRatio;
+    zoomVFO.setInSamplerate(effectiveSr);
+    zoomVFO.setOutSamplerate(zoomSr, zoomSr);
+    zoomVFO.setOffset((zoomStart + (0.5 / (double)zoomRatio) - 0.5) * effectiveSr);
+
+    // Same FFT as the whole band, at the decimated samplerate. Frames are full length, overlapping when the FFT rate needs it.
+    int skip, nzSampCount, averages;
+    genReshapeParams(zoomSr, _fftSize, _fftRate, _fftAverages, _fftOverlap, skip, nzSampCount, averages);
+    zoomReshape.setKeep(nzSampCount);
+    zoomReshape.setSkip(skip);
+    std::vector<float> windowBuf(nzSampCount);
+    genFFTWindow(windowBuf.data(), nzSampCount);
+    zoomPipeline.setParams(_fftSize, windowBuf.data(), nzSampCount, averages);
+    zoomPipeline.setView(genZoomView());
 
     // Restart branch
-    reshape.tempStart();
-    fftSink.tempStart();
+    zoomVFO.tempStart();
+    zoomReshape.tempStart();
+    zoomSink.tempStart();
+}
+
+void IQFrontEnd::setZoomed(bool enabled) {
+    if (enabled == zoomed) { return; }
+
+    // The new FFT is bound before the old one is unbound so that no spectrum is missed
+    if (enabled) {
+        split.bindStream(&zoomIn);
+        split.unbindStream(&fftIn);
+    }
+    else {
+        split.bindStream(&fftIn);
+        split.unbindStream(&zoomIn);
+    }
+    zoomed = enabled;
+}
+
+dsp::fft::SpectrumView IQFrontEnd::genZoomView() {
+    // The view relative to the zoom band
+    dsp::fft::SpectrumView view = fftView;
+    view.start = (fftView.start - zoomStart) * (double)zoomRatio;
+    view.width = fftView.width * (double)zoomRatio;
+    return view;
 }
\ No newline at end of file
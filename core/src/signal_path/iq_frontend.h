@@ -6,9 +6,27 @@
 #include "../dsp/chain.h"
 #include "../dsp/routing/splitter.h"
 #include "../dsp/channel/rx_vfo.h"
+#include "../dsp/channel/pfb_channelizer.h"
 #include "../dsp/sink/handler_sink.h"
 #include "../dsp/math/conjugate.h"
-#include <fftw3.h>
+#include "../dsp/fft/spectrum_pipeline.h"
+#include <mutex>
+
+// Number of narrow VFOs from which they share a channelizer instead of each processing the full rate IQ
+#define IQFRONTEND_CHANNELIZER_MIN_VFOS     4
+
+// Minimum spacing between the channels of the channelizer, VFOs up to half as wide go through it
+#define IQFRONTEND_CHANNELIZER_SPACING      100e3
+
+// Largest fraction of the zoom FFT's band the view may take up, the rest covers the edges of the decimation filters
+#define IQFRONTEND_ZOOM_MAX_FILL            0.8
+
+// Fraction of the zoom FFT's band the view may move into at either edge before the band is retuned around it
+#define IQFRONTEND_ZOOM_MARGIN              0.05
+
+// Longest a zoom FFT frame may last in seconds. Frames are full length, so each zoom step doubles their duration,
+// which smears the waterfall over time and delays the first zoomed spectrum. This caps the zoom ratio.
+#define IQFRONTEND_ZOOM_MAX_FRAME_TIME      0.5
 
 class IQFrontEnd {
 public:
@@ -23,6 +41,7 @@ public:
     void init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool buffering, int decimRatio, bool dcBlocking, int fftSize, double fftRate, FFTWindow fftWindow, float* (*acquireFFTBuffer)(void* ctx), void (*releaseFFTBuffer)(void* ctx), void* fftCtx);
 
     void setInput(dsp::stream<dsp::complex_t>* in);
+    void setInput(dsp::stream<dsp::complex16_t>* in);
     void setSampleRate(double sampleRate);
     inline double getSampleRate() { return _sampleRate / _decimRatio; }
 
@@ -37,10 +56,31 @@ public:
     dsp::channel::RxVFO* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
     void removeVFO(std::string name);
 
+    // Number of narrow VFOs from which they share the channelizer, zero to never use it
+    void setChannelizerMinVFOs(int count);
+
     void setFFTSize(int size);
     void setFFTRate(double rate);
     void setFFTWindow(FFTWindow fftWindow);
 
+    // Average the power of up to this many frames per spectrum, overlapping by at most the given fraction of a frame.
+    // The overlap only limits averaged frames, single frames overlap as much as the FFT rate needs.
+    void setFFTAverages(int averages);
+    void setFFTOverlap(double overlap);
+
+    // Number of threads computing spectra, zero to pick one depending on the core count
+    void setFFTThreads(int threads);
+
+    // Hand over only the part of the spectrum on screen, reduced to one value per pixel, instead of the whole FFT.
+    // The FFT buffer callbacks can get the view of the spectrum they're handed with getDeliveredFFTView().
+    void setFFTView(const dsp::fft::SpectrumView& view);
+    const dsp::fft::SpectrumView& getDeliveredFFTView();
+
+    // While the view is narrower than the resolution of the FFT, compute its spectrum from the view's band alone,
+    // translated and decimated so that the same FFT size resolves it in finer detail. Needs a view with pixels.
+    // The resolution gained is limited by IQFRONTEND_ZOOM_MAX_FRAME_TIME.
+    void setFFTZoom(bool enabled);
+
     void flushInputBuffer();
 
     void start();
@@ -50,21 +90,66 @@ public:
 
 protected:
     static void handler(dsp::complex_t* data, int count, void* ctx);
+    static void zoomHandler(dsp::complex_t* data, int count, void* ctx);
+    static float* acquireFFTBuffer(void* ctx);
+    static void releaseFFTBuffer(void* ctx);
+    static float* acquireZoomBuffer(void* ctx);
+    static void releaseZoomBuffer(void* ctx);
     void updateFFTPath(bool updateWaterfall = false);
+    void genFFTWindow(float* buf, int size);
+
+    void updateZoom(bool retune = false);
+    void updateZoomPath(int ratio, double start);
+    void setZoomed(bool zoomed);
+    dsp::fft::SpectrumView genZoomView();
+
+    static void vfoRetuned(dsp::channel::RxVFO* vfo, void* ctx);
+    void updateChannelization();
+    void setChannelized(const std::string& name, bool channelized);
+
+    static inline int genChannelCount(double sampleRate) {
+        int channels = 1;
+        while (channels < 4096 && sampleRate / (double)(channels * 2) >= IQFRONTEND_CHANNELIZER_SPACING) { channels *= 2; }
+        return channels;
+    }
 
     static inline double genDCBlockRate(double sampleRate) {
         return 50.0 / sampleRate;
     }
 
-    static inline void genReshapeParams(double sampleRate, int size, double rate, int& skip, int& nzSampCount) {
-        int fftInterval = round(sampleRate / rate);
-        nzSampCount = std::min<int>(fftInterval, size);
-        skip = fftInterval - nzSampCount;
+    // Largest power of two decimation that doesn't fill too much of the decimated band with the view, and keeps frames
+    // no longer than IQFRONTEND_ZOOM_MAX_FRAME_TIME. One if the FFT of the whole band already resolves the view.
+    static inline int genZoomRatio(const dsp::fft::SpectrumView& view, int fftSize, double sampleRate) {
+        if (view.pixels <= 0 || view.width * (double)fftSize >= (double)view.pixels) { return 1; }
+        int maxRatio = std::min<int>(dsp::multirate::PowerDecimator<dsp::complex_t>::getMaxRatio(), sampleRate * IQFRONTEND_ZOOM_MAX_FRAME_TIME / (double)fftSize);
+        int ratio = 1;
+        while (ratio * 2 <= maxRatio && view.width * (double)(ratio * 2) <= IQFRONTEND_ZOOM_MAX_FILL) { ratio *= 2; }
+        return ratio;
+    }
+
+    static inline void genReshapeParams(double sampleRate, int size, double rate, int averages, double overlap, int& skip, int& nzSampCount, int& frameAverages) {
+        int fftInterval = std::max<int>(round(sampleRate / rate), 1);
+        nzSampCount = size;
+
+        // Averaged frames are spread evenly over the interval, as many as fit without overlapping more than asked.
+        // Frames are always full length, when the interval is shorter than a frame each one starts an interval after
+        // the previous one and they overlap as much as the rate needs. A negative skip makes the reshaper overlap the frames.
+        int minHop = std::max<int>(round(size * (1.0 - overlap)), 1);
+        frameAverages = std::clamp<int>(fftInterval / minHop, 1, averages);
+        skip = (fftInterval / frameAverages) - size;
     }
 
     // Input buffer
     dsp::buffer::SampleFrameBuffer<dsp::complex_t> inBuf;
 
+    // 16 bit input, decimated before being converted and fed to the pre-processing chain in place of the float input.
+    // Whichever input isn't used is left on an empty stream.
+    dsp::stream<dsp::complex_t> nullIn;
+    dsp::stream<dsp::complex16_t> nullIn16;
+    dsp::buffer::SampleFrameBuffer<dsp::complex16_t> inBuf16;
+    dsp::multirate::PowerDecimator<dsp::complex_t, dsp::complex16_t> decim16;
+    bool int16Input = false;
+
     // Pre-processing chain
     dsp::multirate::PowerDecimator<dsp::complex_t> decim;
     dsp::math::Conjugate conjugate;
@@ -78,10 +163,38 @@ protected:
     dsp::stream<dsp::complex_t> fftIn;
     dsp::buffer::Reshaper<dsp::complex_t> reshape;
     dsp::sink::Handler<dsp::complex_t> fftSink;
+    dsp::fft::SpectrumPipeline fftPipeline;
+    int fftThreads = 0;
+
+    // Zoom FFT, only bound to the splitter in place of the FFT while zoomed in. The band it covers starts at zoomStart
+    // and is 1 / zoomRatio of the whole spectrum wide, both only change while its chain is stopped and its pipeline flushed.
+    dsp::stream<dsp::complex_t> zoomIn;
+    dsp::channel::RxVFO zoomVFO;
+    dsp::buffer::Reshaper<dsp::complex_t> zoomReshape;
+    dsp::sink::Handler<dsp::complex_t> zoomSink;
+    dsp::fft::SpectrumPipeline zoomPipeline;
+    int zoomRatio = 1;
+    double zoomStart = 0.0;
+    bool zoomEnabled = true;
+    bool zoomed = false;
+    dsp::fft::SpectrumView fftView;
+    std::recursive_mutex zoomMtx;
+
+    // Both FFTs hand over spectra one at a time, along with the view they cover
+    std::mutex deliverMtx;
+    dsp::fft::SpectrumView deliveredView;
 
     // VFOs
     std::map<std::string, dsp::stream<dsp::complex_t>*> vfoStreams;
     std::map<std::string, dsp::channel::RxVFO*> vfos;
+    std::map<std::string, bool> vfoChannelized;
+    std::recursive_mutex vfoMtx;
+
+    // Channelizer shared by narrow VFOs, only bound to the splitter while used
+    dsp::stream<dsp::complex_t> chanIn;
+    dsp::channel::PFBChannelizer channelizer;
+    int channelizedCount = 0;
+    int channelizerMinVFOs = IQFRONTEND_CHANNELIZER_MIN_VFOS;
 
     // Parameters
     double _sampleRate;
@@ -89,16 +202,14 @@ protected:
     int _fftSize;
     double _fftRate;
     FFTWindow _fftWindow;
+    int _fftAverages = 1;
+    double _fftOverlap = 0.5;
     float* (*_acquireFFTBuffer)(void* ctx);
     void (*_releaseFFTBuffer)(void* ctx);
     void* _fftCtx;
 
     // Processing data
     int _nzFFTSize;
-    float* fftWindowBuf;
-    fftwf_complex *fftInBuf, *fftOutBuf;
-    fftwf_plan fftwPlan;
-    float* fftDbOut;
 
     double effectiveSr;
 
@@ -51,10 +51,12 @@ void SourceManager::selectSource(std::string name) {
     selectedHandler->selectHandler(selectedHandler->ctx);
     selectedName = name;
     if (core::args["server"].b()) {
-        server::setInput(selectedHandler->stream);
+        if (selectedHandler->stream16) { server::setInput(selectedHandler->stream16); }
+        else { server::setInput(selectedHandler->stream); }
     }
     else {
-        sigpath::iqFrontEnd.setInput(selectedHandler->stream);
+        if (selectedHandler->stream16) { sigpath::iqFrontEnd.setInput(selectedHandler->stream16); }
+        else { sigpath::iqFrontEnd.setInput(selectedHandler->stream); }
     }
     // Set server input here
 }
@@ -12,6 +12,8 @@ public:
 
     struct SourceHandler {
         dsp::stream<dsp::complex_t>* stream;
+        // Sources with 16 bit samples can set this instead, they are then converted after the first decimation stage
+        dsp::stream<dsp::complex16_t>* stream16 = NULL;
         void (*menuHandler)(void* ctx);
         void (*selectHandler)(void* ctx);
         void (*deselectHandler)(void* ctx);
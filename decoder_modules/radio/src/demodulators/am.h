@@ -25,6 +25,9 @@ namespace demod {
             if (config->conf[name][getName()].contains("agcDecay")) {
                 agcDecay = config->conf[name][getName()]["agcDecay"];
             }
+            if (config->conf[name][getName()].contains("agcLookAhead")) {
+                agcLookAhead = config->conf[name][getName()]["agcLookAhead"];
+            }
             if (config->conf[name][getName()].contains("carrierAgc")) {
                 carrierAgc = config->conf[name][getName()]["carrierAgc"];
             }
@@ -32,6 +35,7 @@ namespace demod {
 
             // Define structure
             demod.init(input, carrierAgc ? dsp::demod::AM<dsp::stereo_t>::AGCMode::CARRIER : dsp::demod::AM<dsp::stereo_t>::AGCMode::AUDIO, bandwidth, agcAttack / getIFSampleRate(), agcDecay / getIFSampleRate(), 100.0 / getIFSampleRate(), getIFSampleRate());
+            demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
         }
 
         void start() { demod.start(); }
@@ -56,6 +60,14 @@ namespace demod {
                 _config->conf[name][getName()]["agcDecay"] = agcDecay;
                 _config->release(true);
             }
+            ImGui::LeftLabel("AGC Look-ahead");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::SliderFloat(("##_radio_am_agc_lookahead_" + name).c_str(), &agcLookAhead, 0.0f, 100.0f, (agcLookAhead > 0.0f) ? "%.0fms" : "Block")) {
+                demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
+                _config->acquire();
+                _config->conf[name][getName()]["agcLookAhead"] = agcLookAhead;
+                _config->release(true);
+            }
             if (ImGui::Checkbox(("Carrier AGC##_radio_am_carrier_agc_" + name).c_str(), &carrierAgc)) {
                 demod.setAGCMode(carrierAgc ? dsp::demod::AM<dsp::stereo_t>::AGCMode::CARRIER : dsp::demod::AM<dsp::stereo_t>::AGCMode::AUDIO);
                 _config->acquire();
@@ -95,6 +107,7 @@ namespace demod {
 
         float agcAttack = 50.0f;
         float agcDecay = 5.0f;
+        float agcLookAhead = 0.0f;
         bool carrierAgc = false;
 
         std::string name;
@@ -28,6 +28,9 @@ namespace demod {
             if (config->conf[name][getName()].contains("agcDecay")) {
                 agcDecay = config->conf[name][getName()]["agcDecay"];
             }
+            if (config->conf[name][getName()].contains("agcLookAhead")) {
+                agcLookAhead = config->conf[name][getName()]["agcLookAhead"];
+            }
             if (config->conf[name][getName()].contains("tone")) {
                 tone = config->conf[name][getName()]["tone"];
             }
@@ -35,6 +38,7 @@ namespace demod {
 
             // Define structure
             demod.init(input, tone, agcAttack / getIFSampleRate(), agcDecay / getIFSampleRate(), getIFSampleRate());
+            demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
         }
 
         void start() { demod.start(); }
@@ -59,6 +63,14 @@ namespace demod {
                 _config->conf[name][getName()]["agcDecay"] = agcDecay;
                 _config->release(true);
             }
+            ImGui::LeftLabel("AGC Look-ahead");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::SliderFloat(("##_radio_cw_agc_lookahead_" + name).c_str(), &agcLookAhead, 0.0f, 100.0f, (agcLookAhead > 0.0f) ? "%.0fms" : "Block")) {
+                demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
+                _config->acquire();
+                _config->conf[name][getName()]["agcLookAhead"] = agcLookAhead;
+                _config->release(true);
+            }
             ImGui::LeftLabel("Tone Frequency");
             ImGui::FillWidth();
             if (ImGui::InputInt(("Stereo##_radio_cw_tone_" + name).c_str(), &tone, 10, 100)) {
@@ -102,6 +114,7 @@ namespace demod {
 
         float agcAttack = 100.0f;
         float agcDecay = 5.0f;
+        float agcLookAhead = 0.0f;
         int tone = 800;
 
         EventHandler<float> afbwChangeHandler;
@@ -28,10 +28,14 @@ namespace demod {
             if (config->conf[name][getName()].contains("agcDecay")) {
                 agcDecay = config->conf[name][getName()]["agcDecay"];
             }
+            if (config->conf[name][getName()].contains("agcLookAhead")) {
+                agcLookAhead = config->conf[name][getName()]["agcLookAhead"];
+            }
             config->release();
 
             // Define structure
             demod.init(input, dsp::demod::SSB<dsp::stereo_t>::Mode::USB, bandwidth, getIFSampleRate(), agcAttack / getIFSampleRate(), agcDecay / getIFSampleRate());
+            demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
         }
 
         void start() { demod.start(); }
@@ -56,6 +60,14 @@ namespace demod {
                 _config->conf[name][getName()]["agcDecay"] = agcDecay;
                 _config->release(true);
             }
+            ImGui::LeftLabel("AGC Look-ahead");
+            ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+            if (ImGui::SliderFloat(("##_radio_usb_agc_lookahead_" + name).c_str(), &agcLookAhead, 0.0f, 100.0f, (agcLookAhead > 0.0f) ? "%.0fms" : "Block")) {
+                demod.setAGCLookAhead(agcLookAhead * getIFSampleRate() / 1000.0);
+                _config->acquire();
+                _config->conf[name][getName()]["agcLookAhead"] = agcLookAhead;
+                _config->release(true);
+            }
         }
 
         void setBandwidth(double bandwidth) { demod.setBandwidth(bandwidth); }
@@ -89,6 +101,7 @@ namespace demod {
 
         float agcAttack = 50.0f;
         float agcDecay = 5.0f;
+        float agcLookAhead = 0.0f;
 
         std::string name;
     };
@@ -77,6 +77,7 @@ public:
         ifChain.addBlock(&nb, false);
         ifChain.addBlock(&squelch, false);
         ifChain.addBlock(&fmnr, false);
+        ifChain.setFused(true, [](dsp::stream<dsp::complex_t>* out){});
 
         // Initialize audio DSP chain
         afChain.init(&dummyAudioStream);
@@ -86,6 +87,7 @@ public:
 
         afChain.addBlock(&resamp, true);
         afChain.addBlock(&deemp, false);
+        afChain.setFused(true, [](dsp::stream<dsp::stereo_t>* out){});
 
         // Initialize the sink
         srChangeHandler.ctx = this;
@@ -274,6 +276,11 @@ private:
                 }
                 if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
             }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::beginDisabled(); }
+            if (ImGui::Checkbox(("Fast IF Noise Reduction##_radio_fmifnr_fast_" + _this->name).c_str(), &_this->FMIFNRFast)) {
+                _this->setFMIFNRFast(_this->FMIFNRFast);
+            }
+            if (!_this->FMIFNREnabled && _this->enabled) { style::endDisabled(); }
         }
 
         // Demodulator specific menu
@@ -367,6 +374,7 @@ private:
         postProcEnabled = selectedDemod->getPostProcEnabled();
         FMIFNRAllowed = selectedDemod->getFMIFNRAllowed();
         FMIFNREnabled = false;
+        FMIFNRFast = false;
         fmIFPresetId = ifnrPresets.valueId(IFNR_PRESET_VOICE);
         nbAllowed = selectedDemod->getNBAllowed();
         nbEnabled = false;
@@ -399,6 +407,9 @@ private:
         if (config.conf[name][selectedDemod->getName()].contains("FMIFNREnabled")) {
             FMIFNREnabled = config.conf[name][selectedDemod->getName()]["FMIFNREnabled"];
         }
+        if (config.conf[name][selectedDemod->getName()].contains("FMIFNRFast")) {
+            FMIFNRFast = config.conf[name][selectedDemod->getName()]["FMIFNRFast"];
+        }
         if (config.conf[name][selectedDemod->getName()].contains("fmifnrPreset")) {
             std::string presetOpt = config.conf[name][selectedDemod->getName()]["fmifnrPreset"];
             if (ifnrPresets.keyExists(presetOpt)) {
@@ -431,6 +442,7 @@ private:
 
         // Configure FM IF Noise Reduction
         setIFNRPreset((selectedDemodID == RADIO_DEMOD_NFM) ? ifnrPresets[fmIFPresetId] : IFNR_PRESET_BROADCAST);
+        setFMIFNRFast(FMIFNRFast);
         setFMIFNREnabled(FMIFNRAllowed ? FMIFNREnabled : false);
 
         // Configure squelch
@@ -561,6 +573,19 @@ private:
         config.release(true);
     }
 
+    void setFMIFNRFast(bool fast) {
+        FMIFNRFast = fast;
+        if (!selectedDemod) { return; }
+
+        // Searching for the strongest bin every other sample halves the FFTs but costs about 0.25dB of SNR
+        fmnr.setHop(FMIFNRFast ? 2 : 1);
+
+        // Save config
+        config.acquire();
+        config.conf[name][selectedDemod->getName()]["FMIFNRFast"] = FMIFNRFast;
+        config.release(true);
+    }
+
     void setIFNRPreset(IFNRPreset preset) {
         // Don't save if in broadcast mode
         if (preset == IFNR_PRESET_BROADCAST) {
@@ -687,6 +712,7 @@ private:
 
     bool FMIFNRAllowed;
     bool FMIFNREnabled = false;
+    bool FMIFNRFast = false;
     int fmIFPresetId;
 
     bool notchEnabled = false;
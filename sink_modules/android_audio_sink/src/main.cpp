@@ -99,6 +99,7 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("Audio Sink");
         while (true) {
             int count = packer.out.read();
             if (count < 0) { return; }
@@ -193,6 +193,7 @@ private:
         opts.streamName = _streamName;
 
         try {
+            threadSetup = false;
             audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
             stereoPacker.setSampleCount(bufferFrames);
             audio.startStream();
@@ -221,6 +222,13 @@ private:
 
     static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
         AudioSink* _this = (AudioSink*)userData;
+
+        // The callback thread belongs to the audio API, so it can only be set up from here
+        if (!_this->threadSetup) {
+            dsp::threading::setupCurrentThread("Audio Sink " + _this->_streamName);
+            _this->threadSetup = true;
+        }
+
         int count = _this->stereoPacker.out.read();
         if (count < 0) { return 0; }
 
@@ -235,6 +243,7 @@ private:
     dsp::buffer::Packer<dsp::stereo_t> stereoPacker;
 
     std::string _streamName;
+    bool threadSetup = false;
 
     int srId = 0;
     int devCount;
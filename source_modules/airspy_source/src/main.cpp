@@ -41,7 +41,8 @@ public:
         handler.startHandler = start;
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
-        handler.stream = &stream;
+        handler.stream = NULL;
+        handler.stream16 = &stream;
 
         refresh();
         if (sampleRateList.size() > 0) {
@@ -277,6 +278,8 @@ private:
             return;
         }
 
+        // Get the library's int16 samples, they only get converted to CF32 once decimated
+        airspy_set_sample_type(_this->openDev, AIRSPY_SAMPLE_INT16_IQ);
         airspy_set_samplerate(_this->openDev, _this->sampleRateList[_this->srId]);
         airspy_set_freq(_this->openDev, _this->freq);
 
@@ -564,7 +567,8 @@ private:
 
     static int callback(airspy_transfer_t* transfer) {
         AirspySourceModule* _this = (AirspySourceModule*)transfer->ctx;
-        memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_t));
+        dsp::threading::setupCallbackThread("Airspy Source");
+        memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex16_t));
         if (!_this->stream.swap(transfer->sample_count)) { return -1; }
         return 0;
     }
@@ -572,7 +576,7 @@ private:
     std::string name;
     airspy_device* openDev;
     bool enabled = true;
-    dsp::stream<dsp::complex_t> stream;
+    dsp::stream<dsp::complex16_t> stream;
     double sampleRate;
     SourceManager::SourceHandler handler;
     bool running = false;
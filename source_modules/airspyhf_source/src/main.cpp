@@ -373,6 +373,7 @@ private:
 
     static int callback(airspyhf_transfer_t* transfer) {
         AirspyHFSourceModule* _this = (AirspyHFSourceModule*)transfer->ctx;
+        dsp::threading::setupCallbackThread("AirspyHF+ Source");
         memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_t));
         if (!_this->stream.swap(transfer->sample_count)) { return -1; }
         return 0;
@@ -264,6 +264,7 @@ private:
 
     static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
         AudioSourceModule* _this = (AudioSourceModule*)userData;
+        dsp::threading::setupCallbackThread("Audio Source");
         memcpy(_this->stream.writeBuf, inputBuffer, nBufferFrames * sizeof(dsp::complex_t));
         _this->stream.swap(nBufferFrames);
         return 0;
@@ -51,7 +51,8 @@ public:
         handler.startHandler = start;
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
-        handler.stream = &stream;
+        handler.stream = NULL;
+        handler.stream16 = &stream;
 
         refresh();
 
@@ -575,26 +576,22 @@ private:
     }
 
     void worker() {
-        int16_t* buffer = new int16_t[bufferSize * 2];
+        dsp::threading::setupCurrentThread("BladeRF Source");
         bladerf_metadata meta;
 
         while (streamingEnabled) {
-            // Receive from the stream and break on error
-            int ret = bladerf_sync_rx(openDev, buffer, bufferSize, &meta, 3500);
+            // Receive from the stream and break on error. Samples are sent as is, they only get converted to CF32 once decimated.
+            int ret = bladerf_sync_rx(openDev, stream.writeBuf, bufferSize, &meta, 3500);
             if (ret != 0) { break; }
 
-            // Convert to complex float and swap buffers
-            volk_16i_s32f_convert_32f((float*)stream.writeBuf, buffer, 32768.0f, bufferSize * 2);
             if (!stream.swap(bufferSize)) { break; }
         }
-
-        delete[] buffer;
     }
 
     std::string name;
     bladerf* openDev;
     bool enabled = true;
-    dsp::stream<dsp::complex_t> stream;
+    dsp::stream<dsp::complex16_t> stream;
     double sampleRate;
     SourceManager::SourceHandler handler;
     bool running = false;
@@ -449,6 +449,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("FobosSDR Source");
+
         // Select different processing depending on the mode
         if (port == PORT_RF && sampleRate >= 50e6) {
             while (run) {
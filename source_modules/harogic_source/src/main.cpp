@@ -407,6 +407,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("Harogic Source");
+
         // Allocate sample buffer
         int realSamps = bufferSize*2;
         IQStream_TypeDef iqs;
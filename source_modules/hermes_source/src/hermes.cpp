@@ -1,4 +1,5 @@
 #include "hermes.h"
+#include <dsp/threading.h>
 #include <utils/flog.h>
 
 namespace hermes {
@@ -163,6 +164,7 @@ namespace hermes {
     }
 
     void Client::worker() {
+        dsp::threading::setupCurrentThread("Hermes Source");
         uint8_t rbuf[2048];
         MetisUSBPacket* pkt = (MetisUSBPacket*)rbuf;
         int sampleCount = 0;
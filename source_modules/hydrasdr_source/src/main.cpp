@@ -575,6 +575,7 @@ private:
 
     static int callback(hydrasdr_transfer_t* transfer) {
         HydraSDRSourceModule* _this = (HydraSDRSourceModule*)transfer->ctx;
+        dsp::threading::setupCallbackThread("HydraSDR Source");
         memcpy(_this->stream.writeBuf, transfer->samples, transfer->sample_count * sizeof(dsp::complex_t));
         if (!_this->stream.swap(transfer->sample_count)) { return -1; }
         return 0;
@@ -256,6 +256,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("KCSDR Source");
+
         // Compute the buffer size
         int bufferSize = 0x4000/4;//sampleRate / 200;
 
@@ -480,6 +480,7 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("LimeSDR Source");
         int sampCount = sampleRate / 200;
         lms_stream_meta_t meta;
         while (streamRunning) {
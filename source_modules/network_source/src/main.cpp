@@ -274,6 +274,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("Network Source");
+
         // Compute sizes
         int blockSize = samplerate / 200;
         int sampleSize = SAMPLE_TYPE_SIZE[sampType];
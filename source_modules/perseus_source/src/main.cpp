@@ -404,6 +404,7 @@ private:
 
     static int callback(void* buf, int bufferSize, void* ctx) {
         PerseusSourceModule* _this = (PerseusSourceModule*)ctx;
+        dsp::threading::setupCallbackThread("Perseus Source");
         uint8_t* samples = (uint8_t*)buf;
         int sampleCount = bufferSize / 6;
         for (int i = 0; i < sampleCount; i++) {
@@ -69,7 +69,8 @@ public:
         handler.startHandler = start;
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
-        handler.stream = &stream;
+        handler.stream = NULL;
+        handler.stream16 = &stream;
         sigpath::sourceManager.registerSource("PlutoSDR", &handler);
     }
 
@@ -446,6 +447,7 @@ private:
 
     static void worker(void* ctx) {
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
+        dsp::threading::setupCurrentThread("PlutoSDR Source");
         int blockSize = _this->samplerate / 200.0f;
 
         // Acquire channels
@@ -476,8 +478,8 @@ private:
             int16_t* buf = (int16_t*)iio_buffer_first(rxbuf, rx0_i);
             if (!buf) { break; }
 
-            // Convert samples to CF32
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, buf, 32768.0f, blockSize * 2);
+            // Samples are sent as is, they only get converted to CF32 once decimated
+            memcpy(_this->stream.writeBuf, buf, blockSize * sizeof(dsp::complex16_t));
 
             // Send out the samples
             if (!_this->stream.swap(blockSize)) { break; };
@@ -493,7 +495,7 @@ private:
 
     std::string name;
     bool enabled = true;
-    dsp::stream<dsp::complex_t> stream;
+    dsp::stream<dsp::complex16_t> stream;
     SourceManager::SourceHandler handler;
     std::thread workerThread;
     iio_context* ctx = NULL;
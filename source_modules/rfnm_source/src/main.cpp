@@ -32,7 +32,8 @@ public:
         handler.startHandler = start;
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
-        handler.stream = &stream;
+        handler.stream = NULL;
+        handler.stream16 = &stream;
 
         // Refresh devices
         refresh();
@@ -425,6 +426,7 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("RFNM Source");
         librfnm_rx_buf* lrxbuf;
         int sampCount = bufferSize/4;
         uint8_t ch = (1 << currentPath.chId);
@@ -445,8 +447,8 @@ private:
             }
             else if (fail) { break; }
 
-            // Convert buffer to CF32
-            volk_16i_s32f_convert_32f((float*)&stream.writeBuf[(count++)*sampCount], (int16_t*)lrxbuf->buf, 32768.0f, sampCount * 2);
+            // Samples are sent as is, they only get converted to CF32 once decimated
+            memcpy(&stream.writeBuf[(count++)*sampCount], lrxbuf->buf, sampCount * sizeof(dsp::complex16_t));
 
             // Reque buffer
             openDev->rx_qbuf(lrxbuf);
@@ -464,7 +466,7 @@ private:
 
     std::string name;
     bool enabled = true;
-    dsp::stream<dsp::complex_t> stream;
+    dsp::stream<dsp::complex16_t> stream;
     double sampleRate;
     SourceManager::SourceHandler handler;
     bool running = false;
@@ -1,4 +1,5 @@
 #include <rfspace_client.h>
+#include <dsp/threading.h>
 #include <volk/volk.h>
 #include <cstring>
 #include <utils/flog.h>
@@ -211,6 +212,8 @@ namespace rfspace {
     }
 
     void Client::udpWorker() {
+        dsp::threading::setupCurrentThread("RFspace Source");
+
         // Allocate receive buffer
         uint8_t* buffer = new uint8_t[RFSPACE_MAX_SIZE];
         uint16_t* header = (uint16_t*)&buffer[0];
@@ -524,6 +524,7 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("RTL-SDR Source");
         rtlsdr_reset_buffer(openDev);
         rtlsdr_read_async(openDev, asyncHandler, this, 0, asyncCount);
     }
@@ -1,4 +1,5 @@
 #include "rtl_tcp_client.h"
+#include <dsp/threading.h>
 
 namespace rtltcp {
     Client::Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* stream) {
@@ -73,6 +74,7 @@ namespace rtltcp {
     }
 
     void Client::worker() {
+        dsp::threading::setupCurrentThread("RTL-TCP Source");
         uint8_t* buffer = dsp::buffer::alloc<uint8_t>(STREAM_BUFFER_SIZE*2);
 
         while (true) {
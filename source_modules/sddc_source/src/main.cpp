@@ -393,6 +393,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("SDDC Source");
+
         // // Select different processing depending on the mode
         // if (port == PORT_RF && sampleRate >= 50e6) {
         //     while (run) {
@@ -1,4 +1,5 @@
 #include "sdrpp_server_client.h"
+#include <dsp/threading.h>
 #include <volk/volk.h>
 #include <cstring>
 #include <utils/flog.h>
@@ -162,6 +163,7 @@ namespace server {
     }
 
     void Client::worker() {
+        dsp::threading::setupCurrentThread("SDR++ Server Source");
         while (true) {
             // Receive header
             if (sock->recv(rbuffer, sizeof(PacketHeader), true) <= 0) {
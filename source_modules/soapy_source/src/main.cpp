@@ -498,6 +498,7 @@ private:
     }
 
     static void _worker(SoapyModule* _this) {
+        dsp::threading::setupCurrentThread("SoapySDR Source");
         int blockSize = _this->sampleRate / 200.0f;
         int flags = 0;
         long long timeMs = 0;
@@ -1,4 +1,5 @@
 #include "spectran_http_client.h"
+#include <dsp/threading.h>
 #include <utils/flog.h>
 #include <inttypes.h>
 
@@ -77,6 +78,7 @@ void SpectranHTTPClient::setCenterFrequency(uint64_t freq) {
 }
 
 void SpectranHTTPClient::worker() {
+    dsp::threading::setupCurrentThread("Spectran HTTP Source");
     while (sock->isOpen()) {
         // Get chunk header
         net::http::ChunkHeader chdr;
@@ -402,6 +402,7 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("Spectran Source");
         AARTSAAPI_Packet pkt = { sizeof(AARTSAAPI_Packet) };
         AARTSAAPI_Result res;
 
@@ -1,4 +1,5 @@
 #include <spyserver_client.h>
+#include <dsp/threading.h>
 #include <volk/volk.h>
 #include <cstring>
 #include <chrono>
@@ -108,6 +109,7 @@ namespace spyserver {
 
     void SpyServerClientClass::dataHandler(int count, uint8_t* buf, void* ctx) {
         SpyServerClientClass* _this = (SpyServerClientClass*)ctx;
+        dsp::threading::setupCallbackThread("SpyServer Source");
 
         if (count < sizeof(SpyServerMessageHeader)) {
             _this->readSize(sizeof(SpyServerMessageHeader) - count, &buf[count]);
@@ -433,6 +433,8 @@ private:
     }
 
     void worker() {
+        dsp::threading::setupCurrentThread("USRP Source");
+
         // TODO: Select a better buffer size that will avoid bad timing
         int bufferSize = sampleRate / 200;
         try {